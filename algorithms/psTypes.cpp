@@ -2,19 +2,24 @@
 
 namespace particle_structs {
 
-elemCoords::elemCoords(int ne, int np, int s) {
+template <typename Real>
+elemCoordsOf<Real>::elemCoordsOf(int ne, int np, int s) {
   num_elems = ne;
   verts_per_elem = np;
   size = s*np;
-  x = new fp_t[s*np];
-  y = new fp_t[s*np];
-  z = new fp_t[s*np];
+  x = new Real[s*np];
+  y = new Real[s*np];
+  z = new Real[s*np];
 }
 
-elemCoords::~elemCoords() {
+template <typename Real>
+elemCoordsOf<Real>::~elemCoordsOf() {
   delete [] x;
   delete [] y;
   delete [] z;
 }
 
+template class elemCoordsOf<float>;
+template class elemCoordsOf<double>;
+
 }
@@ -5,33 +5,41 @@
 
 namespace particle_structs {
 
-#ifdef FP64
-typedef double fp_t;
-#endif
+//Default floating point type, set by the FP64/FP32 options of the build
 #ifdef FP32
 typedef float fp_t;
+#else
+typedef double fp_t;
 #endif
 
 typedef int lid_t;
 
-typedef fp_t Vector3d[3];
+/* The types below take their floating point type as a template parameter so species of
+   different precision can be held in one build, the unparameterized names use fp_t
+*/
+template <typename Real> using Vector3dOf = Real[3];
+typedef Vector3dOf<fp_t> Vector3d;
 
 //Particle = <current position vector, pushed position vector>
-typedef MemberTypes<Vector3d, Vector3d> Particle;
+template <typename Real> using ParticleOf = MemberTypes<Vector3dOf<Real>, Vector3dOf<Real> >;
+typedef ParticleOf<fp_t> Particle;
 
-class elemCoords {
+//Instantiated for float and double
+template <typename Real>
+class elemCoordsOf {
   public:
   int num_elems;
   int verts_per_elem;
   int size;
-  fp_t* x;
-  fp_t* y;
-  fp_t* z;
-  elemCoords(int ne, int np, int size);
-  ~elemCoords();
+  Real* x;
+  Real* y;
+  Real* z;
+  elemCoordsOf(int ne, int np, int size);
+  ~elemCoordsOf();
   private:
-    elemCoords() {};
+    elemCoordsOf() {};
 };
+typedef elemCoordsOf<fp_t> elemCoords;
 
 }
 
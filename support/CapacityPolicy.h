@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cmath>
+#include <Kokkos_Core.hpp>
+#include "SCS_Types.h"
+
+namespace particle_structs {
+
+/* Controls how much memory the SCS reserves beyond the particles it holds
+   over_allocation - ratio of allocated member entries to the capacity of the structure
+   shrink_threshold - the member allocation is shrunk when the capacity falls below
+                      this fraction of it (0 never shrinks)
+   row_slack - empty slots reserved for each element at rebuild as a multiple of the
+               number of particles that moved into the element in that rebuild
+   min_row_slack - empty slots reserved at rebuild for every element with particles
+   max_row_width - rows are capped at this many slots and the remaining particles of heavier
+                   elements are stored in a compact overflow region (0 disables the cap)
+   split_rows - heavier elements are split across several rows of at most max_row_width
+                slots instead of using the overflow region
+   skip_empty - elements without particles get no row, they are given a row by the rebuild
+                that first sends particles to them
+*/
+struct CapacityPolicy {
+  CapacityPolicy(double over = 1.1, double shrink = 0, double slack = 0, lid_t min_slack = 0,
+                 lid_t max_width = 0, bool split = false, bool skip = false) :
+    over_allocation(over), shrink_threshold(shrink), row_slack(slack),
+    min_row_slack(min_slack), max_row_width(max_width), split_rows(split), skip_empty(skip) {}
+
+  //Returns the number of entries to allocate for a capacity of cap
+  std::size_t allocation(std::size_t cap) const {return cap * over_allocation;}
+
+  /* Returns the allocation to use for a capacity of cap given the current allocation
+     The current allocation is kept unless it is too small or shrinking is triggered
+  */
+  std::size_t reallocation(std::size_t cap, std::size_t current) const {
+    if (current < cap || cap < shrink_threshold * current)
+      return allocation(cap);
+    return current;
+  }
+
+  //Returns true if rows reserve empty slots at rebuild
+  bool hasSlack() const {return row_slack > 0 || min_row_slack > 0;}
+  //Returns true if heavy rows spill into the overflow region
+  bool hasOverflow() const {return max_row_width > 0 && !split_rows;}
+  //Returns true if heavy elements are split across several rows
+  bool hasSplitRows() const {return max_row_width > 0 && split_rows;}
+
+  //Number of empty slots reserved for an element with count particles and inflow arrivals
+  template <typename Lid>
+  KOKKOS_INLINE_FUNCTION static Lid slack(Lid count, Lid inflow, double row_slack,
+                                          Lid min_row_slack) {
+    const Lid reserve = static_cast<Lid>(ceil(row_slack * inflow));
+    return (count > 0) * (reserve > min_row_slack ? reserve : min_row_slack);
+  }
+
+  double over_allocation;
+  double shrink_threshold;
+  double row_slack;
+  lid_t min_row_slack;
+  lid_t max_row_width;
+  bool split_rows;
+  bool skip_empty;
+};
+
+//Caps a row size at max_width (0 leaves the size unchanged)
+template <typename Lid>
+KOKKOS_INLINE_FUNCTION Lid capRowSize(Lid size, Lid max_width) {
+  return (max_width > 0 && size > max_width) ? max_width : size;
+}
+
+/* Returns the slot of the k-th particle placed in an element
+   The particles fill the rows of the element in elem_rows[elem_row_offs[elem]:
+   elem_row_offs[elem+1]], each row holding row_widths[row] particles from row_starts[row]
+   with a stride of C. The rest fill the overflow slots of the element from overflow_start.
+*/
+template <typename LidView, typename Lid = typename LidView::non_const_value_type>
+KOKKOS_INLINE_FUNCTION Lid elementSlot(Lid k, Lid elem, const LidView& elem_row_offs,
+                                       const LidView& elem_rows, const LidView& row_widths,
+                                       const LidView& row_starts, Lid C, Lid overflow_start) {
+  for (Lid j = elem_row_offs(elem); j < elem_row_offs(elem+1); ++j) {
+    const Lid row = elem_rows(j);
+    const Lid width = row_widths(row);
+    if (k < width)
+      return row_starts(row) + k * C;
+    k -= width;
+  }
+  return overflow_start + k;
+}
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "MemberTypeLibraries.h"
+#include <Kokkos_Core.hpp>
+
+namespace particle_structs {
+
+/* Per element data stored in the row order of a structure
+   Entry r holds the data of the element of row r so the rows of a chunk read the data of
+   their elements contiguously. The structure reorders the entries whenever its rows change.
+*/
+template <typename LidView>
+class ElementArrayBase {
+ public:
+  virtual ~ElementArrayBase() {}
+  /* Replaces the entries by a view of src_entries.size() entries where entry i is a copy of
+     entry src_entries(i) of the current view (entries with a source of -1 are left empty)
+  */
+  virtual void permute(LidView src_entries) = 0;
+  //Returns a new array with a copy of the entries
+  virtual ElementArrayBase* copy() const = 0;
+};
+
+template <typename T, typename LidView>
+class ElementArray : public ElementArrayBase<LidView> {
+ public:
+  ElementArray(MemberTypeView<T> values) : view(values) {}
+
+  void permute(LidView src_entries) {
+    typedef typename LidView::non_const_value_type lid_t;
+    MemberTypeView<T> dst("element_array", src_entries.size());
+    MemberTypeView<T> src = view;
+    Kokkos::parallel_for("permute_element_array", src_entries.size(),
+                         KOKKOS_LAMBDA(const lid_t& i) {
+      const lid_t src_index = src_entries(i);
+      if (src_index >= 0)
+        CopyTiledEntry<T, Kokkos::DefaultExecutionSpace::device_type>(dst, i, 0,
+                                                                      src, src_index, 0);
+    });
+    view = dst;
+  }
+
+  ElementArrayBase<LidView>* copy() const {
+    MemberTypeView<T> values("element_array", view.extent(0));
+    Kokkos::deep_copy(values, view);
+    return new ElementArray(values);
+  }
+
+  MemberTypeView<T> view;
+};
+
+}
@@ -11,279 +11,351 @@
 
 namespace particle_structs {
 
-  //This type represents an array of views for each type of the given DataTypes
-  template <typename DataTypes> using MemberTypeViews = void**;
-  template <typename DataTypes> using MemberTypeViewsConst = void* const*;
   //TODO don't use default execution space
   template <typename T> using MemberTypeView = 
     Kokkos::View<T*, Kokkos::DefaultExecutionSpace::device_type>;
 
-  template <typename... Types> struct CreateViewsImpl;
-  template <> struct CreateViewsImpl<> {
-    CreateViewsImpl(MemberTypeViews<MemberTypes<void> >, int) {}
+  /* Typed storage of a view for each of the given Types
+     The views are held by value so copies share the member data and the container can be
+     captured directly in device lambdas. A default constructed container holds no views.
+  */
+  template <typename... Types> struct MemberViewTuple;
+  template <> struct MemberViewTuple<> {
+    MemberViewTuple() {}
+    MemberViewTuple(std::size_t) {}
+    bool isAllocated() const {return false;}
   };
-  template <typename T, typename... Types> struct CreateViewsImpl<T, Types...> {
-    CreateViewsImpl(MemberTypeViews<MemberTypes<T, Types...> > views, int size) {
-      
-      views[0] = new MemberTypeView<T>("datatype_view", size);
-      MemberTypeView<T> view = *static_cast<MemberTypeView<T>*>(views[0]);
-      CreateViewsImpl<Types...>(views+1, size);
-    }
+  template <typename T, typename... Types> struct MemberViewTuple<T, Types...> {
+    MemberViewTuple() {}
+    //Allocates a view of size entries for each type
+    MemberViewTuple(std::size_t size) : view("datatype_view", size), rest(size) {}
+
+    //Returns true if the views have been allocated
+    bool isAllocated() const {return view.data() != NULL;}
+
+    MemberTypeView<T> view;
+    MemberViewTuple<Types...> rest;
   };
 
-  template <typename... Types> struct CreateViews;
-  template <typename... Types> struct CreateViews<MemberTypes<Types...> > {
-    CreateViews(MemberTypeViews<MemberTypes<Types...> >& views, int size) {
-      views = new void*[MemberTypes<Types...>::size];
-      CreateViewsImpl<Types...>(views, size);
+  //This type represents a view for each type of the given DataTypes
+  template <typename DataTypes> struct MemberViewTupleOf;
+  template <typename... Types> struct MemberViewTupleOf<MemberTypes<Types...> > {
+    using type = MemberViewTuple<Types...>;
+  };
+  template <typename DataTypes> using MemberTypeViews =
+    typename MemberViewTupleOf<DataTypes>::type;
+
+  //Access to the view of the Nth type of a MemberViewTuple
+  template <std::size_t N, typename... Types> struct MemberViewAt;
+  template <typename T, typename... Types> struct MemberViewAt<0, T, Types...> {
+    using type = T;
+    KOKKOS_INLINE_FUNCTION static const MemberTypeView<T>&
+    get(const MemberViewTuple<T, Types...>& views) {return views.view;}
+  };
+  template <std::size_t N, typename T, typename... Types> struct MemberViewAt<N, T, Types...> {
+    using type = typename MemberViewAt<N-1, Types...>::type;
+    KOKKOS_INLINE_FUNCTION static const MemberTypeView<type>&
+    get(const MemberViewTuple<T, Types...>& views) {
+      return MemberViewAt<N-1, Types...>::get(views.rest);
     }
   };
 
   template <typename DataTypes>
-  MemberTypeViews<DataTypes> createMemberViews(int size) {
-    MemberTypeViews<DataTypes> views;
-    CreateViews<DataTypes>(views, size);
-    return views;
+  MemberTypeViews<DataTypes> createMemberViews(std::size_t size) {
+    return MemberTypeViews<DataTypes>(size);
+  }
+  //Returns the view of the Nth type, usable in device code
+  template <std::size_t N, typename... Types>
+  KOKKOS_INLINE_FUNCTION
+  const MemberTypeView<typename MemberViewAt<N, Types...>::type>&
+  getMemberView(const MemberViewTuple<Types...>& views) {
+    return MemberViewAt<N, Types...>::get(views);
   }
   template <typename DataTypes, size_t N>
   MemberTypeView<typename MemberTypeAtIndex<N, DataTypes>::type>
-  getMemberView(MemberTypeViews<DataTypes> view) {
-    using Type = typename MemberTypeAtIndex<N, DataTypes>::type;
-    return *(static_cast<MemberTypeView<Type>*>(view[N]));
+  getMemberView(const MemberTypeViews<DataTypes>& views) {
+    return getMemberView<N>(views);
   }
 
-  template <typename SCS, typename... Types> struct CopyParticlesToSendImpl;
-  template <typename SCS> struct CopyParticlesToSendImpl<SCS> {
-    CopyParticlesToSendImpl(SCS* scs, MemberTypeViewsConst<MemberTypes<void> >,
-                       MemberTypeViewsConst<MemberTypes<void> >,
-                       typename SCS::kkLidView, typename SCS::kkLidView) {}
-  };
-  template <typename SCS, typename T, typename... Types> struct CopyParticlesToSendImpl<SCS, T,Types...> {
-    CopyParticlesToSendImpl(SCS* scs, MemberTypeViewsConst<MemberTypes<T, Types...> > dsts,
-                       MemberTypeViewsConst<MemberTypes<T, Types...> > srcs,
-                       typename SCS::kkLidView scs_to_array,
-                       typename SCS::kkLidView array_indices) {
-      enclose(scs, dsts, srcs,scs_to_array, array_indices);
-    }
-    void enclose(SCS* scs, MemberTypeViewsConst<MemberTypes<T, Types...> > dsts,
-                 MemberTypeViewsConst<MemberTypes<T, Types...> > srcs,
-                 typename SCS::kkLidView scs_to_array,
-                 typename SCS::kkLidView array_indices) {
+  //Bit mask selecting every member, bit N of a member mask selects the Nth member
+  constexpr unsigned int all_members = ~0u;
+
+  //Copy entry src_index of each member of srcs to entry dst_index of dsts in one pass
+  //  members - bit mask of the members to copy
+  template <typename DstLid, typename SrcLid>
+  KOKKOS_INLINE_FUNCTION void copyMemberEntries(const MemberViewTuple<>&, DstLid, int,
+                                                const MemberViewTuple<>&, SrcLid, int,
+                                                unsigned int = all_members) {}
+  template <typename T, typename... Types, typename DstLid, typename SrcLid>
+  KOKKOS_INLINE_FUNCTION void copyMemberEntries(const MemberViewTuple<T, Types...>& dsts,
+                                                DstLid dst_index, int dst_tile,
+                                                const MemberViewTuple<T, Types...>& srcs,
+                                                SrcLid src_index, int src_tile,
+                                                unsigned int members = all_members) {
+    if (members & 1u)
+      CopyTiledEntry<T, Kokkos::DefaultExecutionSpace::device_type>(dsts.view, dst_index,
+                                                                    dst_tile, srcs.view,
+                                                                    src_index, src_tile);
+    copyMemberEntries(dsts.rest, dst_index, dst_tile, srcs.rest, src_index, src_tile,
+                      members >> 1);
+  }
+
+  //Copy the particles leaving this process into the send views at array_indices
+  template <typename SCS, typename DataTypes> struct CopyParticlesToSend {
+    CopyParticlesToSend(SCS* scs, MemberTypeViews<DataTypes> dsts,
+                        MemberTypeViews<DataTypes> srcs,
+                        typename SCS::kkLidView scs_to_array,
+                        typename SCS::kkLidView array_indices) {
       int comm_rank;
       MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
-      MemberTypeView<T> dst = *static_cast<MemberTypeView<T> const*>(dsts[0]);
-      MemberTypeView<T> src = *static_cast<MemberTypeView<T> const*>(srcs[0]);
-      auto copySCSToArray = SCS_LAMBDA(int elm_id, int ptcl_id, bool mask) {
-        const int arr_index = scs_to_array(ptcl_id);
+      typedef typename SCS::lid_t lid_t;
+      const int src_tile = scs->tileHeight();
+      auto copySCSToArray = SCS_LAMBDA(lid_t elm_id, lid_t ptcl_id, bool mask) {
+        const lid_t arr_index = scs_to_array(ptcl_id);
         if (mask && arr_index != comm_rank) {
-          const int index = array_indices(ptcl_id);
-          CopyViewToView<T,Kokkos::DefaultExecutionSpace::device_type>(dst, index, src, ptcl_id);
+          const lid_t index = array_indices(ptcl_id);
+          copyMemberEntries(dsts, index, 0, srcs, ptcl_id, src_tile);
         }
       };
       scs->parallel_for(copySCSToArray);
-      CopyParticlesToSendImpl<SCS, Types...>(scs, dsts+1, srcs+1, scs_to_array, array_indices);
-    }
-
-  };
-  template <typename SCS, typename... Types> struct CopyParticlesToSend;
-  template <typename SCS,typename... Types> struct CopyParticlesToSend<SCS, MemberTypes<Types...> > {
-    CopyParticlesToSend(SCS* scs, MemberTypeViewsConst<MemberTypes<Types...> > dsts,  
-                   MemberTypeViewsConst<MemberTypes<Types...> > srcs,
-                   typename SCS::kkLidView scs_to_array,
-                   typename SCS::kkLidView array_indices) {
-      CopyParticlesToSendImpl<SCS, Types...>(scs, dsts, srcs, scs_to_array, array_indices);
     }
   };
 
-  template <typename SCS, typename... Types> struct CopySCSToSCSImpl;
-  template <typename SCS> struct CopySCSToSCSImpl<SCS> {
-    CopySCSToSCSImpl(SCS* scs, MemberTypeViewsConst<MemberTypes<void> >,
-                     MemberTypeViewsConst<MemberTypes<void> >, typename SCS::kkLidView,
-                     typename SCS::kkLidView) {}
-  };
-  template <typename SCS, typename T, typename... Types> struct CopySCSToSCSImpl<SCS, T,Types...> {
-    CopySCSToSCSImpl(SCS* scs, MemberTypeViewsConst<MemberTypes<T, Types...> > dsts,
-                     MemberTypeViewsConst<MemberTypes<T, Types...> > srcs,
-                     typename SCS::kkLidView new_element,
-                     typename SCS::kkLidView scs_indices) {
-      enclose(scs,dsts,srcs,new_element, scs_indices);
-    }
-    void enclose(SCS* scs, MemberTypeViewsConst<MemberTypes<T, Types...> > dsts,
-                 MemberTypeViewsConst<MemberTypes<T, Types...> > srcs,
+  //Copy the selected members of the particles that stay in the structure to their new scs index
+  template <typename SCS, typename DataTypes> struct CopySCSToSCS {
+    CopySCSToSCS(SCS* scs, MemberTypeViews<DataTypes> dsts, int dst_tile,
+                 MemberTypeViews<DataTypes> srcs,
                  typename SCS::kkLidView new_element,
-                 typename SCS::kkLidView scs_indices) {
-      MemberTypeView<T> dst = *static_cast<MemberTypeView<T> const*>(dsts[0]);
-      MemberTypeView<T> src = *static_cast<MemberTypeView<T> const*>(srcs[0]);
-      auto copySCSToSCS = SCS_LAMBDA(int elm_id, int ptcl_id, bool mask) {
+                 typename SCS::kkLidView scs_indices,
+                 unsigned int members = all_members) {
+      typedef typename SCS::lid_t lid_t;
+      const int src_tile = scs->tileHeight();
+      auto copySCSToSCS = SCS_LAMBDA(lid_t elm_id, lid_t ptcl_id, bool mask) {
         const lid_t new_elem = new_element(ptcl_id);
         if (mask && new_elem != -1) {
-          const int index = scs_indices(ptcl_id);
-          CopyViewToView<T,Kokkos::DefaultExecutionSpace::device_type>(dst, index, src, ptcl_id);
+          const lid_t index = scs_indices(ptcl_id);
+          copyMemberEntries(dsts, index, dst_tile, srcs, ptcl_id, src_tile, members);
         }
       };
       scs->parallel_for(copySCSToSCS);
-      CopySCSToSCSImpl<SCS, Types...>(scs, dsts+1, srcs+1, new_element, scs_indices);
-    }
-    
-  };
-  template <typename SCS, typename... Types> struct CopySCSToSCS;
-  template <typename SCS,typename... Types> struct CopySCSToSCS<SCS, MemberTypes<Types...> > {
-    CopySCSToSCS(SCS* scs, MemberTypeViewsConst<MemberTypes<Types...> > dsts,  
-                 MemberTypeViewsConst<MemberTypes<Types...> > srcs,
-                 typename SCS::kkLidView new_element,
-                 typename SCS::kkLidView scs_indices) {
-      CopySCSToSCSImpl<SCS, Types...>(scs, dsts, srcs, new_element, scs_indices);
     }
   };
 
-
-  template <typename SCS, typename... Types> struct CopyNewParticlesToSCSImpl;
-  template <typename SCS> struct CopyNewParticlesToSCSImpl<SCS> {
-    CopyNewParticlesToSCSImpl(SCS* scs, MemberTypeViewsConst<MemberTypes<void> >,
-                              MemberTypeViewsConst<MemberTypes<void> >, int,
-                              typename SCS::kkLidView) {}
-  };
-  template <typename SCS, typename T, typename... Types> struct CopyNewParticlesToSCSImpl<SCS, T,Types...> {
-    CopyNewParticlesToSCSImpl(SCS* scs, MemberTypeViewsConst<MemberTypes<T, Types...> > dsts,
-                              MemberTypeViewsConst<MemberTypes<T, Types...> > srcs, int ne,
-                     typename SCS::kkLidView scs_indices) {
-      enclose(scs,dsts,srcs,ne, scs_indices);
-    }
-    void enclose(SCS* scs, MemberTypeViewsConst<MemberTypes<T, Types...> > dsts,
-                 MemberTypeViewsConst<MemberTypes<T, Types...> > srcs, int ne,
-                 typename SCS::kkLidView scs_indices) {
-      MemberTypeView<T> dst = *static_cast<MemberTypeView<T> const*>(dsts[0]);
-      MemberTypeView<T> src = *static_cast<MemberTypeView<T> const*>(srcs[0]);
-      Kokkos::parallel_for(ne, KOKKOS_LAMBDA(const int& i) {
-        const int index = scs_indices(i);
-        CopyViewToView<T,Kokkos::DefaultExecutionSpace::device_type>(dst, index, src, i);
+  //Copy the selected members of the ne new particles in srcs to their scs index
+  template <typename SCS, typename DataTypes> struct CopyNewParticlesToSCS {
+    CopyNewParticlesToSCS(SCS* scs, MemberTypeViews<DataTypes> dsts, int dst_tile,
+                          MemberTypeViews<DataTypes> srcs, int ne,
+                          typename SCS::kkLidView scs_indices,
+                          unsigned int members = all_members) {
+      typedef typename SCS::lid_t lid_t;
+      Kokkos::parallel_for(ne, KOKKOS_LAMBDA(const lid_t& i) {
+        const lid_t index = scs_indices(i);
+        copyMemberEntries(dsts, index, dst_tile, srcs, i, 0, members);
       });
-      CopyNewParticlesToSCSImpl<SCS, Types...>(scs, dsts+1, srcs+1, ne, scs_indices);
-    }
-  };
-  template <typename SCS, typename... Types> struct CopyNewParticlesToSCS;
-  template <typename SCS,typename... Types> struct CopyNewParticlesToSCS<SCS, MemberTypes<Types...> > {
-    CopyNewParticlesToSCS(SCS* scs, MemberTypeViewsConst<MemberTypes<Types...> > dsts,  
-                          MemberTypeViewsConst<MemberTypes<Types...> > srcs, int ne, 
-                 typename SCS::kkLidView scs_indices) {
-      CopyNewParticlesToSCSImpl<SCS, Types...>(scs, dsts, srcs, ne, scs_indices);
     }
   };
 
-  //Shuffle copy currying structs
-  template <typename LidView, typename... Types> struct ShuffleParticlesImpl;
-  template <typename LidView> struct ShuffleParticlesImpl<LidView> {
-    ShuffleParticlesImpl(MemberTypeViewsConst<MemberTypes<void> > scs,
-                         MemberTypeViewsConst<MemberTypes<void> > new_particles,
-                         LidView old_indices, LidView new_indices, LidView fromSCS) {}
-  };
-  template <typename LidView, typename T, typename... Types>
-  struct ShuffleParticlesImpl<LidView, T, Types...> {
-    ShuffleParticlesImpl(MemberTypeViewsConst<MemberTypes<T, Types...> > scs,
-                         MemberTypeViewsConst<MemberTypes<T, Types...> > new_particles,
-                         LidView old_indices, LidView new_indices, LidView fromSCS) {
-      enclose(scs, new_particles, old_indices, new_indices, fromSCS);
+  /* Moves particles to their new scs index one member at a time
+     Each member is copied into a staging view of dst_size entries that then replaces the
+     member view, so only one member is duplicated at any time instead of the full structure.
+     Members not selected by members keep their views.
+  */
+  template <typename SCS>
+  void stageSCSToSCS(SCS*, MemberViewTuple<>&, int, std::size_t, typename SCS::kkLidView,
+                     typename SCS::kkLidView, unsigned int) {}
+  template <typename SCS, typename T, typename... Types>
+  void stageSCSToSCS(SCS* scs, MemberViewTuple<T, Types...>& views, int dst_tile,
+                     std::size_t dst_size, typename SCS::kkLidView new_element,
+                     typename SCS::kkLidView scs_indices, unsigned int members) {
+    if (!(members & 1u)) {
+      stageSCSToSCS(scs, views.rest, dst_tile, dst_size, new_element, scs_indices,
+                    members >> 1);
+      return;
     }
-    void enclose(MemberTypeViewsConst<MemberTypes<T, Types...> > scs,
-                 MemberTypeViewsConst<MemberTypes<T, Types...> > new_particles,
-                 LidView old_indices, LidView new_indices, LidView fromSCS) {
-      int nMoving = old_indices.size();
-      MemberTypeView<T> scs_view = *static_cast<MemberTypeView<T> const*>(scs[0]);
-      MemberTypeView<T> new_view;
-      if (new_particles != NULL) {
-        new_view = *static_cast<MemberTypeView<T> const*>(new_particles[0]);
-        new_particles++;
+    MemberTypeView<T> dst("datatype_view", dst_size);
+    MemberTypeView<T> src = views.view;
+    typedef typename SCS::lid_t lid_t;
+    const int src_tile = scs->tileHeight();
+    auto stageMember = SCS_LAMBDA(lid_t elm_id, lid_t ptcl_id, bool mask) {
+      const lid_t new_elem = new_element(ptcl_id);
+      if (mask && new_elem != -1) {
+        const lid_t index = scs_indices(ptcl_id);
+        CopyTiledEntry<T,Kokkos::DefaultExecutionSpace::device_type>(dst, index, dst_tile,
+                                                                     src, ptcl_id, src_tile);
       }
+    };
+    scs->parallel_for(stageMember);
+    views.view = dst;
+    stageSCSToSCS(scs, views.rest, dst_tile, dst_size, new_element, scs_indices,
+                  members >> 1);
+  }
+  template <typename SCS, typename DataTypes> struct StageSCSToSCS {
+    StageSCSToSCS(SCS* scs, MemberTypeViews<DataTypes>& views, int dst_tile,
+                  std::size_t dst_size, typename SCS::kkLidView new_element,
+                  typename SCS::kkLidView scs_indices, unsigned int members = all_members) {
+      stageSCSToSCS(scs, views, dst_tile, dst_size, new_element, scs_indices, members);
+    }
+  };
 
+  /* Shuffle the selected members of the moving particles to new_indices
+     Particles with fromSCS set are read from the scs at old_indices, the others are read
+     from new_particles
+  */
+  template <typename LidView, typename DataTypes> struct ShuffleParticles {
+    ShuffleParticles(MemberTypeViews<DataTypes> scs, int tile,
+                     MemberTypeViews<DataTypes> new_particles,
+                     LidView old_indices, LidView new_indices, LidView fromSCS,
+                     unsigned int members = all_members) {
+      typedef typename LidView::non_const_value_type lid_t;
+      const lid_t nMoving = old_indices.size();
       Kokkos::parallel_for(nMoving, KOKKOS_LAMBDA(const lid_t& i) {
-          const lid_t old_index = old_indices(i);
-          const lid_t new_index = new_indices(i);
-          const lid_t isSCS = fromSCS(i);
-          auto src = (isSCS == 1 ? scs_view : new_view);
-          CopyViewToView<T, Kokkos::DefaultExecutionSpace::device_type>(scs_view, new_index,
-                                                                        src, old_index);
+        const lid_t old_index = old_indices(i);
+        const lid_t new_index = new_indices(i);
+        const lid_t isSCS = fromSCS(i);
+        if (isSCS == 1)
+          copyMemberEntries(scs, new_index, tile, scs, old_index, tile, members);
+        else
+          copyMemberEntries(scs, new_index, tile, new_particles, old_index, 0, members);
       });
-      ShuffleParticlesImpl<LidView, Types...>(scs+1, new_particles, old_indices,
-                                              new_indices, fromSCS);
-    }
-  };
-  template <typename LidView, typename... Types> struct ShuffleParticles;
-  template <typename LidView, typename... Types> struct ShuffleParticles<LidView, MemberTypes<Types...> > {
-    ShuffleParticles(MemberTypeViewsConst<MemberTypes<Types...> > scs,
-                     MemberTypeViewsConst<MemberTypes<Types...> > new_particles,
-                     LidView old_indices, LidView new_indices, LidView fromSCS) {
-      ShuffleParticlesImpl<LidView, Types...>(scs, new_particles, old_indices, new_indices, fromSCS);
     }
   };
 
-  template <typename... Types> struct SendViewsImpl;
-  template <> struct SendViewsImpl<> {
-    SendViewsImpl(MemberTypeViews<MemberTypes<void> > views, int offset, int size, 
-                  int dest, int tag, MPI_Request* reqs) {}
-  };
-  template <typename T, typename... Types> struct SendViewsImpl<T, Types... > {
-    SendViewsImpl(MemberTypeViews<MemberTypes<T, Types...> > views, int offset, int size, 
-                  int dest, int tag, MPI_Request* reqs) {
-      MemberTypeView<T> v = *static_cast<MemberTypeView<T>*>(views[0]);
-      PS_Comm_Isend(v, offset, size, dest, tag, MPI_COMM_WORLD, reqs);
-      SendViewsImpl<Types...>(views+1, offset, size, dest, tag + 1, reqs + 1);
+  //Copy the first n entries between member views with different tile heights
+  template <typename DataTypes> struct RetileViews {
+    RetileViews(MemberTypeViews<DataTypes> dsts, int dst_tile,
+                MemberTypeViews<DataTypes> srcs, int src_tile, std::size_t n) {
+      Kokkos::parallel_for(n, KOKKOS_LAMBDA(const std::size_t& i) {
+        copyMemberEntries(dsts, i, dst_tile, srcs, i, src_tile);
+      });
     }
   };
 
-  template <typename... Types> struct SendViews;
-  template <typename... Types> struct SendViews<MemberTypes<Types...> > {
-    SendViews(MemberTypeViews<MemberTypes<Types...> > views, int offset, int size, 
-              int dest, int start_tag, MPI_Request* reqs) {
-      SendViewsImpl<Types...>(views, offset, size, dest, start_tag, reqs);
+  /* Relayout the first n entries of each selected member one member at a time through a
+     staging view of size entries
+  */
+  inline void retileViewsInPlace(MemberViewTuple<>&, int, int, std::size_t, std::size_t,
+                                 unsigned int) {}
+  template <typename T, typename... Types>
+  void retileViewsInPlace(MemberViewTuple<T, Types...>& views, int dst_tile, int src_tile,
+                          std::size_t n, std::size_t size, unsigned int members) {
+    if (!(members & 1u)) {
+      retileViewsInPlace(views.rest, dst_tile, src_tile, n, size, members >> 1);
+      return;
     }
-  };
-
-  template <typename... Types> struct RecvViewsImpl;
-  template <> struct RecvViewsImpl<> {
-    RecvViewsImpl(MemberTypeViews<MemberTypes<void> > views, int offset, int size, 
-                  int dest, int tag, MPI_Request* reqs) {}
-  };
-  template <typename T, typename... Types> struct RecvViewsImpl<T, Types... > {
-    RecvViewsImpl(MemberTypeViews<MemberTypes<T, Types...> > views, int offset, int size, 
-                  int dest, int tag, MPI_Request* reqs) {
-      MemberTypeView<T> v = *static_cast<MemberTypeView<T>*>(views[0]);
-      PS_Comm_Irecv(v, offset, size, dest, tag, MPI_COMM_WORLD, reqs);
-      RecvViewsImpl<Types...>(views+1, offset, size, dest, tag + 1, reqs + 1);
+    MemberTypeView<T> dst("datatype_view", size);
+    MemberTypeView<T> src = views.view;
+    Kokkos::parallel_for(n, KOKKOS_LAMBDA(const std::size_t& i) {
+      CopyTiledEntry<T, Kokkos::DefaultExecutionSpace::device_type>(dst, i, dst_tile,
+                                                                    src, i, src_tile);
+    });
+    views.view = dst;
+    retileViewsInPlace(views.rest, dst_tile, src_tile, n, size, members >> 1);
+  }
+  template <typename DataTypes> struct RetileViewsInPlace {
+    RetileViewsInPlace(MemberTypeViews<DataTypes>& views, int dst_tile,
+                       int src_tile, std::size_t n, std::size_t size,
+                       unsigned int members = all_members) {
+      retileViewsInPlace(views, dst_tile, src_tile, n, size, members);
     }
   };
 
-  template <typename... Types> struct RecvViews;
-  template <typename... Types> struct RecvViews<MemberTypes<Types...> > {
-    RecvViews(MemberTypeViews<MemberTypes<Types...> > views, int offset, int size, 
-              int dest, int start_tag, MPI_Request* reqs) {
-      RecvViewsImpl<Types...>(views, offset, size, dest, start_tag, reqs);
+  /* Gathers each selected member into a view of dst_size entries in slot order
+     The entry of each slot with a particle is read from src_indices(slot) of the member
+  */
+  template <typename SCS>
+  void gatherMembers(SCS*, MemberViewTuple<>&, int, std::size_t, int,
+                     typename SCS::kkLidView, unsigned int) {}
+  template <typename SCS, typename T, typename... Types>
+  void gatherMembers(SCS* scs, MemberViewTuple<T, Types...>& views, int dst_tile,
+                     std::size_t dst_size, int src_tile, typename SCS::kkLidView src_indices,
+                     unsigned int members) {
+    if (members & 1u) {
+      MemberTypeView<T> dst("datatype_view", dst_size);
+      MemberTypeView<T> src = views.view;
+      typedef typename SCS::lid_t lid_t;
+      auto gatherMember = SCS_LAMBDA(lid_t elm_id, lid_t ptcl_id, bool mask) {
+        if (mask)
+          CopyTiledEntry<T,Kokkos::DefaultExecutionSpace::device_type>(dst, ptcl_id, dst_tile,
+                                                                       src,
+                                                                       src_indices(ptcl_id),
+                                                                       src_tile);
+      };
+      scs->parallel_for(gatherMember);
+      views.view = dst;
+    }
+    gatherMembers(scs, views.rest, dst_tile, dst_size, src_tile, src_indices, members >> 1);
+  }
+  template <typename SCS, typename DataTypes> struct GatherMembers {
+    GatherMembers(SCS* scs, MemberTypeViews<DataTypes>& views, int dst_tile,
+                  std::size_t dst_size, int src_tile, typename SCS::kkLidView src_indices,
+                  unsigned int members) {
+      gatherMembers(scs, views, dst_tile, dst_size, src_tile, src_indices, members);
     }
   };
 
-  //Implementation to deallocate views of different types
-  template <typename... Types> struct DestroyViewsImpl;
-  template <> struct DestroyViewsImpl<> {
-    DestroyViewsImpl(MemberTypeViews<MemberTypes<void> >) {}
-  };
-  template <typename T, typename... Types> struct DestroyViewsImpl<T,Types...> {
-    DestroyViewsImpl(MemberTypeViews<MemberTypes<T,Types...> > data) {
-      delete static_cast<MemberTypeView<T>*>(data[0]);
-      DestroyViewsImpl<Types...>(data+1);
+  //Replaces the views of the selected members by copies so writes do not reach other holders
+  inline void copyMemberViews(MemberViewTuple<>&, unsigned int) {}
+  template <typename T, typename... Types>
+  void copyMemberViews(MemberViewTuple<T, Types...>& views, unsigned int members) {
+    if ((members & 1u) && views.isAllocated()) {
+      MemberTypeView<T> copy("datatype_view", views.view.extent(0));
+      Kokkos::deep_copy(copy, views.view);
+      views.view = copy;
     }
-  };
+    copyMemberViews(views.rest, members >> 1);
+  }
 
-  //Call to deallocate arrays of different types
-  template <typename... Types> struct DestroyViews;
-  template <typename... Types> struct DestroyViews<MemberTypes<Types...> > {
-    DestroyViews(MemberTypeViews<MemberTypes<Types...> > data) {
-      DestroyViewsImpl<Types...>(data+0);
-      delete [] data;
+  //Exchanges the views of the selected members between a and b
+  inline void swapMemberViews(MemberViewTuple<>&, MemberViewTuple<>&, unsigned int) {}
+  template <typename T, typename... Types>
+  void swapMemberViews(MemberViewTuple<T, Types...>& a, MemberViewTuple<T, Types...>& b,
+                       unsigned int members) {
+    if (members & 1u) {
+      MemberTypeView<T> tmp = a.view;
+      a.view = b.view;
+      b.view = tmp;
     }
-  };
+    swapMemberViews(a.rest, b.rest, members >> 1);
+  }
+
+  //Unmanaged bytes of a migration message
+  typedef Kokkos::View<char*, Kokkos::DefaultExecutionSpace::device_type,
+                       Kokkos::MemoryTraits<Kokkos::Unmanaged> > MessageBytes;
+
+  /* Copies the bytes of size entries of type T from offset of view to bytes, or from bytes
+     to the entries when pack is false. The entries are contiguous so one copy moves them.
+  */
+  template <typename T, typename View>
+  void copyEntryBytes(View view, std::size_t offset, int size, MessageBytes bytes, bool pack) {
+    const std::size_t nbytes = size * sizeof(T);
+    MessageBytes entries(reinterpret_cast<char*>(view.data() + offset * BaseType<T>::size),
+                         nbytes);
+    MessageBytes message(bytes.data(), nbytes);
+    if (pack)
+      Kokkos::deep_copy(message, entries);
+    else
+      Kokkos::deep_copy(entries, message);
+  }
+
+  //Copies size entries from offset of each member to or from bytes, one member after another
+  inline void copyMemberBytes(const MemberViewTuple<>&, std::size_t, int, MessageBytes, bool) {}
+  template <typename T, typename... Types>
+  void copyMemberBytes(const MemberViewTuple<T, Types...>& views, std::size_t offset, int size,
+                       MessageBytes bytes, bool pack) {
+    if (size == 0)
+      return;
+    copyEntryBytes<T>(views.view, offset, size, bytes, pack);
+    const std::size_t nbytes = size * sizeof(T);
+    copyMemberBytes(views.rest, offset, size,
+                    MessageBytes(bytes.data() + nbytes, bytes.size() - nbytes), pack);
+  }
 
+  /* Releases the member views
+     The data is freed once no other copy of the views references it
+  */
   template <typename DataTypes>
-  void destroyViews(MemberTypeViews<DataTypes> data) {
-    DestroyViews<DataTypes>(data+0);
+  void destroyViews(MemberTypeViews<DataTypes>& data) {
+    data = MemberTypeViews<DataTypes>();
   }
 
 
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <Kokkos_Core.hpp>
+#include <string>
+#include "SCS_Types.h"
+#include "SupportKK.h"
+
+namespace particle_structs {
+
+//Counts the number of bits set in a mask word
+KOKKOS_INLINE_FUNCTION int maskPopCount(unsigned int word) {
+#ifdef __CUDA_ARCH__
+  return __popc(word);
+#else
+  return __builtin_popcount(word);
+#endif
+}
+
+/* Bit-packed particle mask with one bit per SCS slot
+   A set bit means there is a particle at that slot. Bits are packed into 32 bit words
+   and written with atomic word operations so neighboring slots can be updated
+   concurrently. LidType is the index type of the slots.
+*/
+template <typename ExecSpace, typename LidType = lid_t>
+class ParticleMask {
+ public:
+  typedef LidType lid_t;
+  typedef unsigned int word_t;
+  typedef Kokkos::View<word_t*, typename ExecSpace::device_type> WordView;
+  typedef typename WordView::HostMirror WordHostMirror;
+  static constexpr lid_t bits_per_word = 32;
+  static constexpr lid_t word_shift = 5;
+  static constexpr lid_t bit_mask = bits_per_word - 1;
+
+  ParticleMask() : num_bits(0) {}
+  //Creates a mask of size slots with no particles
+  ParticleMask(std::string name, lid_t size) : words(name, numWords(size)), num_bits(size) {}
+
+  //Returns the number of words needed to store size bits
+  static lid_t numWords(lid_t size) {return (size + bits_per_word - 1) >> word_shift;}
+
+  //Returns the number of slots in the mask
+  lid_t size() const {return num_bits;}
+  //Returns the underlying words of the mask
+  WordView wordView() const {return words;}
+
+  KOKKOS_INLINE_FUNCTION bool operator()(const lid_t& i) const {
+    return (words(i >> word_shift) >> (i & bit_mask)) & 1u;
+  }
+  KOKKOS_INLINE_FUNCTION void set(const lid_t& i) const {
+    Kokkos::atomic_fetch_or(&words(i >> word_shift), word_t(1u) << (i & bit_mask));
+  }
+  KOKKOS_INLINE_FUNCTION void clear(const lid_t& i) const {
+    Kokkos::atomic_fetch_and(&words(i >> word_shift), ~(word_t(1u) << (i & bit_mask)));
+  }
+
+  //Returns the number of slots with a particle using a popcount per word
+  lid_t count() const {
+    lid_t sum = 0;
+    WordView words_local = words;
+    Kokkos::parallel_reduce("mask_count", words.size(),
+                            KOKKOS_LAMBDA(const lid_t& i, lid_t& s) {
+      s += maskPopCount(words_local(i));
+    }, sum);
+    return sum;
+  }
+
+  //Copies the words to the host, use test() to read the bits of the copy
+  WordHostMirror toHost() const {return deviceToHost(words);}
+  static bool test(const WordHostMirror& host_words, lid_t i) {
+    return (host_words(i >> word_shift) >> (i & bit_mask)) & 1u;
+  }
+
+ private:
+  WordView words;
+  lid_t num_bits;
+};
+
+}
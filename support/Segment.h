@@ -4,38 +4,61 @@
 #include <type_traits>
 namespace particle_structs {
 
-template <typename Type, typename ExecSpace>
+/* Access to the entries of one member of a structure
+   Type - the member type, a const type gives read only access
+   MemoryTraits - the Kokkos memory traits of the view, e.g. Kokkos::Unmanaged to skip the
+                  reference counting when a lambda captures the segment, Kokkos::Restrict
+                  to promise the segment does not alias others or Kokkos::RandomAccess
+                  for gathers
+*/
+template <typename Type, typename ExecSpace, typename LidType = lid_t,
+          typename MemoryTraits = Kokkos::MemoryManaged>
 class Segment {
 public:
   using Base=typename BaseType<Type>::type;
 
-  using ViewType=Kokkos::View<Type*, ExecSpace>;
-  Segment() {}
-  Segment(ViewType v) : view(v){}
+  using ViewType=Kokkos::View<Type*, ExecSpace, MemoryTraits>;
+  Segment() : tile(0) {}
+  /* v - the member view
+     tile_height - number of entries per tile when the member is stored as an array of
+                   structs of arrays (0 for the native layout of the view)
+  */
+  Segment(ViewType v, int tile_height = 0) : view(v), tile(tile_height) {}
   
   template <typename U = Type>
   KOKKOS_INLINE_FUNCTION typename std::enable_if<std::rank<Type>::value == 0 && std::is_same<U, Type>::value, Base>::type&
-    operator()(const int& particle_index) const {
+    operator()(const LidType& particle_index) const {
     return view(particle_index);
   }
   template <typename U = Type>
   KOKKOS_INLINE_FUNCTION typename std::enable_if<std::rank<Type>::value == 1 && std::is_same<U, Type>::value, Base>::type&
-    operator()(const int& particle_index, const int& i) const {
+    operator()(const LidType& particle_index, const int& i) const {
+    if (tile)
+      return view.data()[tiledIndex(particle_index, i, BaseType<Type>::size, tile)];
     return view(particle_index, i);
   }
   template <typename U = Type>
   KOKKOS_INLINE_FUNCTION typename std::enable_if<std::rank<Type>::value == 2 && std::is_same<U, Type>::value, Base>::type&
-    operator()(const int& particle_index, const int& i, const int& j) const {
+    operator()(const LidType& particle_index, const int& i, const int& j) const {
+    if (tile) {
+      const int comp = i * std::extent<Type, 1>::value + j;
+      return view.data()[tiledIndex(particle_index, comp, BaseType<Type>::size, tile)];
+    }
     return view(particle_index, i, j);
   }
   template <typename U = Type>
   KOKKOS_INLINE_FUNCTION typename std::enable_if<std::rank<Type>::value == 3 && std::is_same<U, Type>::value, Base>::type&
-    operator()(const int& particle_index, const int& i, const int& j, const int& k) const {
+    operator()(const LidType& particle_index, const int& i, const int& j, const int& k) const {
+    if (tile) {
+      const int comp = (i * std::extent<Type, 1>::value + j) * std::extent<Type, 2>::value + k;
+      return view.data()[tiledIndex(particle_index, comp, BaseType<Type>::size, tile)];
+    }
     return view(particle_index, i, j, k);
   }
 
 private:
   ViewType view;
+  int tile;
 };
 
 }
@@ -14,6 +14,9 @@
 #include "ViewComm.h"
 #include "Segment.h"
 #include "SCSPair.h"
+#include "ParticleMask.h"
+#include "CapacityPolicy.h"
+#include "ElementArray.h"
 #include <Kokkos_Core.hpp>
 #include <Kokkos_UnorderedMap.hpp>
 #include <Kokkos_Pair.hpp>
@@ -35,20 +38,23 @@ double prebarrier();
 template <typename ExecSpace> 
 using PairView=Kokkos::View<MyPair*, typename ExecSpace::device_type>;
 
-template<class DataTypes, typename ExecSpace = Kokkos::DefaultExecutionSpace>
+template<class DataTypes, typename ExecSpace = Kokkos::DefaultExecutionSpace,
+         lid_t FixedC = 0, lid_t FixedV = 0, typename LidType = lid_t>
 class SellCSigma {
  public:
-  
+  //Local index type of the slots, particles and elements of the structure
+  typedef LidType lid_t;
+
   typedef Kokkos::TeamPolicy<ExecSpace> PolicyType ;
   typedef Kokkos::View<lid_t*, typename ExecSpace::device_type> kkLidView;
   typedef Kokkos::View<gid_t*, typename ExecSpace::device_type> kkGidView;
+  typedef Kokkos::View<const lid_t*, typename ExecSpace::device_type> kkConstLidView;
   typedef typename kkLidView::HostMirror kkLidHostMirror;
   typedef typename kkGidView::HostMirror kkGidHostMirror;
   typedef Kokkos::UnorderedMap<gid_t, lid_t, typename ExecSpace::device_type> GID_Mapping;
+  typedef Kokkos::View<char*, typename ExecSpace::device_type> kkByteView;
 
   SellCSigma() = delete;
-  SellCSigma(const SellCSigma&) = delete;
-  SellCSigma& operator=(const SellCSigma&) = delete;
   /* Constructor of SellCSigma as particle structure
     p - a Kokkos::TeamPolicy that defines the value of C based on the device
     sigma - the sorting parameter 1 = no sorting, INT_MAX = full sorting
@@ -59,40 +65,188 @@ class SellCSigma {
     element_gids - (for MPI parallelism) global ids for each element (size 0 is ignored)
     particle_elements - parent element for each particle (optional)
     particle_info - Initial values for the particle information (optional)
+    cap_policy - over allocation, shrinking and row slack of the structure (optional)
+    When FixedC or FixedV are nonzero the chunk height or the vertical slice width are
+    fixed at compile time, p must then allow a team size of FixedC and
+    vertical_chunk_size is ignored
+    LidType is the index type of the slots, use a 64 bit type when the capacity of the
+    structure can exceed 2^31 slots
   */
   SellCSigma(PolicyType& p,
 	     lid_t sigma, lid_t vertical_chunk_size, lid_t num_elements, lid_t num_particles,
              kkLidView particles_per_element, kkGidView element_gids,
              kkLidView particle_elements = kkLidView(),
-             MemberTypeViews<DataTypes> particle_info = NULL);
+             MemberTypeViews<DataTypes> particle_info = MemberTypeViews<DataTypes>(),
+             CapacityPolicy cap_policy = CapacityPolicy());
   ~SellCSigma();
 
+  //Returns the chunk height c unless it is fixed at compile time
+  KOKKOS_INLINE_FUNCTION static constexpr lid_t chunkHeight(lid_t c) {
+    return FixedC > 0 ? FixedC : c;
+  }
+  //Returns the vertical slice width v unless it is fixed at compile time
+  KOKKOS_INLINE_FUNCTION static constexpr lid_t sliceWidth(lid_t v) {
+    return FixedV > 0 ? FixedV : v;
+  }
+
   //Returns the horizontal slicing(C)
   lid_t C() const {return C_;}
   //Returns the vertical slicing(V)
   lid_t V() const {return V_;}
   //Returns the number of rows in the scs including padded rows
   lid_t numRows() const {return num_chunks * C_;}
+  //Returns the number of element ids including the ids given to padded rows
+  lid_t numElementIds() const {return num_element_ids;}
   //Returns the capacity of the scs including padding
   lid_t capacity() const { return capacity_;}
+  //Returns the number of entries allocated for each member
+  std::size_t memberAllocation() const {return current_size;}
   //Return the number of elements in the SCS
   lid_t nElems() const {return num_elems;}
   //Returns the number of particles managed by the SCS
   lid_t nPtcls() const {return num_ptcls;}
+  //Returns the number of slots in the overflow region of heavy elements
+  lid_t nOverflow() const {return num_overflow;}
+  /* Returns the number of particles in each element
+     The counts are updated by every rebuild, reshuffle and migration from the particles
+     they move, add and remove, so reading them does not need a pass over the slots.
+  */
+  kkConstLidView particlesPerElement() const {return particles_per_element;}
+
+  //Returns the number of entries per member tile (0 when members use the native layout)
+  lid_t tileHeight() const {return tileMembers * C_;}
 
   //Change whether or not to try shuffling
   void setShuffling(bool newS) {tryShuffling = newS;}
+
+  //Returns the capacity policy of the scs
+  const CapacityPolicy& capacityPolicy() const {return capacity_policy;}
+  //Change the capacity policy, takes effect at the next rebuild
+  void setCapacityPolicy(const CapacityPolicy& cap_policy) {capacity_policy = cap_policy;}
+
+  /* Change whether member arrays are tiled to the chunk height C
+     When enabled, each member is stored as an array of structs of arrays where a tile of C
+     slots stores each component contiguously, so the C rows of a slice read
+     x, then y, then z of a Vector3d with unit stride.
+     Existing particle data is relaid out to the new layout.
+  */
+  void setMemberTiling(bool tiled);
+
+  /* Change whether rebuild permutes the particles within the member arrays
+     When enabled, the swap copy of the members is released and rebuild moves the particles
+     one member at a time through a staging view so only one member is ever duplicated.
+     This lowers peak member memory from ~2.2x to ~1.1x the capacity at the cost of
+     an allocation per member in each rebuild.
+  */
+  void setInPlaceRebuild(bool inPlace);
+
+  /* Change whether reshuffle grows only the chunks whose rows run out of empty slots
+     When enabled, a reshuffle that fails for lack of empty slots appends new slices for
+     the overfull chunks at the end of the member storage instead of rebuilding.
+     Particles keep their slots, so the sort, chunk construction and member permutation
+     of a rebuild are skipped. The regrowth still copies the mask, the slice offsets and
+     the cold index over the whole capacity, and reallocates and copies the hot members
+     when their allocation has no room for the new slices, so its cost is O(capacity).
+     Over allocating the members (see CapacityPolicy) avoids the member copy.
+     Structures with overflow slots always rebuild. A full rebuild restores the sorted layout.
+  */
+  void setLocalRegrowth(bool regrow) {localRegrowth = regrow;}
+
+  /* Change which members are cold
+     Cold members are rarely read attributes that rebuild and reshuffle do not move. Their
+     entries stay where they are and each slot reaches its entry through a cold index that
+     is updated in their place, so only the hot members are copied. The cold members are
+     permuted into slot order every interval rebuilds (0 only on demand) and whenever
+     get<N>() of a cold member, setMemberTiling or a migration to other processes needs them.
+     members - bit mask of the cold members, bit N marks the Nth member as cold
+  */
+  void setColdMembers(unsigned int members, int interval = 0);
+  //Returns the bit mask of the cold members
+  unsigned int coldMembers() const {return cold_members;}
+  //Permutes the entries of the cold members into slot order
+  void permuteColdMembers();
+
+  /* Change whether the structure stores the element of every slot
+     The slot elements are refreshed whenever rebuild or reshuffle change the layout and let
+     parallel_for_flat visit the slots with a flat range instead of the slice, row and
+     slot hierarchy of parallel_for.
+  */
+  void setSlotElements(bool store);
+
+  /* Change whether the structure keeps the list of slots holding particles
+     The list and the element of each entry are rebuilt with a scan of the particle mask
+     after every rebuild and reshuffle, parallel_for_active uses them to visit only the
+     particles.
+  */
+  void setActiveSlots(bool store);
+
+  /* Change the order of the elements that the sigma windows are formed from
+     The elements are ordered by increasing key, ties by id, before they are sorted by
+     particle count within each window, so the chunks group elements with nearby keys.
+     A space filling curve index of the element centroids (see mortonKeys) keeps
+     neighboring elements in nearby rows. Takes effect at the next rebuild that sorts the
+     rows, a rebuild that succeeds by reshuffling keeps the current rows.
+     element_keys - a non negative key for each element, an empty view restores the order
+                    of the element ids
+  */
+  void setElementOrder(kkLidView element_keys);
+
+  /* Adds an array of per element data stored in the row order of the structure
+     Entry r of the array holds the data of the element of row r and the entries are
+     reordered by every rebuild that changes the rows. Elements split across several rows
+     have an entry in each row, elements without a row are kept after the rows at
+     numRows() + element and padded rows have empty entries.
+     values - the data of each element indexed by element id
+     Returns the id of the array
+  */
+  template <typename T>
+  int addElementArray(MemberTypeView<T> values);
+  /* Returns the entries of the element array id with data of type T
+     Like the views of get<N>() the entries have to be fetched again after a rebuild
+  */
+  template <typename T>
+  MemberTypeView<T> getElementArray(int id) const;
+
+  /* Returns a snapshot of the structure that restore can return to
+     The snapshot shares the layout and the member views of the structure, a member is
+     copied the first time either of them writes to it through get<N>(), rebuild, reshuffle
+     or migrate. getConst<N>() reads a member without copying it. Segments fetched before
+     the snapshot have to be fetched again. The caller deletes the snapshot.
+  */
+  SellCSigma* snapshot();
+  //Returns the structure to the state of snap, snap can be restored again
+  void restore(SellCSigma* snap);
   
   /* Gets the Nth datatype SCS to be indexed by particle id 
+     MemoryTraits - Kokkos memory traits of the segment (see Segment)
      Example: auto segment = scs->get<0>()
+              auto pushed = scs->get<1, Kokkos::MemoryTraits<Kokkos::Restrict> >()
    */ 
-  template <std::size_t N> 
-  Segment<typename MemberTypeAtIndex<N,DataTypes>::type, ExecSpace> get() {
+  template <std::size_t N, typename MemoryTraits = Kokkos::MemoryManaged>
+  Segment<typename MemberTypeAtIndex<N,DataTypes>::type, ExecSpace, lid_t, MemoryTraits> get() {
     using Type=typename MemberTypeAtIndex<N, DataTypes>::type;
+    if (cold_members >> N & 1u)
+      permuteColdMembers();
+    if (shared_members >> N & 1u)
+      unshareMembers(1u << N);
+    if (num_ptcls == 0)
+      return Segment<Type, ExecSpace, lid_t, MemoryTraits>();
+    return Segment<Type, ExecSpace, lid_t, MemoryTraits>(getMemberView<N>(scs_data),
+                                                         tileHeight());
+  }
+  /* Gets the Nth datatype SCS as a read only segment
+     Example: auto positions = scs->getConst<0, Kokkos::MemoryRandomAccess>()
+   */
+  template <std::size_t N, typename MemoryTraits = Kokkos::MemoryManaged>
+  Segment<const typename MemberTypeAtIndex<N,DataTypes>::type, ExecSpace, lid_t, MemoryTraits>
+  getConst() {
+    using Type=const typename MemberTypeAtIndex<N, DataTypes>::type;
+    if (cold_members >> N & 1u)
+      permuteColdMembers();
     if (num_ptcls == 0)
-      return Segment<Type, ExecSpace>();
-    MemberTypeView<Type>* view = static_cast<MemberTypeView<Type>*>(scs_data[N]);
-    return Segment<Type, ExecSpace>(*view);
+      return Segment<Type, ExecSpace, lid_t, MemoryTraits>();
+    return Segment<Type, ExecSpace, lid_t, MemoryTraits>(getMemberView<N>(scs_data),
+                                                         tileHeight());
   }
 
 
@@ -103,6 +257,27 @@ class SellCSigma {
   */
   void migrate(kkLidView new_element, kkLidView new_process);
 
+  //Returns the global id of each element (size 0 without global ids)
+  kkGidView elementToGid() const {return element_to_gid;}
+  //Returns the map from the global id of each element to its local id
+  GID_Mapping elementGidToLid() const {return element_gid_to_lid;}
+  /* Uses the global ids of the elements of another structure on the same mesh
+     The structures of several species then keep a single copy of the ids and their map.
+  */
+  void shareElementIds(kkGidView elm2Gid, GID_Mapping elmGid2Lid) {
+    element_to_gid = elm2Gid;
+    element_gid_to_lid = elmGid2Lid;
+  }
+
+  //Particles sent and received by a migration
+  struct MigrationBuffers {
+    //Offsets of the particles of each process
+    kkLidHostMirror send_offsets, recv_offsets;
+    //Element gids and member values of the particles
+    kkGidView send_element, recv_element;
+    MemberTypeViews<DataTypes> send_particle, recv_particle;
+  };
+
   /*
     Reshuffles the scs values to the element in new_element[i]
     Calls rebuild if there is not enough space for the shuffle
@@ -112,7 +287,7 @@ class SellCSigma {
       new_particles - the data for the new particles
   */
   bool reshuffle(kkLidView new_element, kkLidView new_particle_elements = kkLidView(),
-                 MemberTypeViews<DataTypes> new_particles = NULL);
+                 MemberTypeViews<DataTypes> new_particles = MemberTypeViews<DataTypes>());
   /*
     Rebuilds a new SCS where particles move to the element in new_element[i]
     new_element - array sized scs->capacity with the new element for each particle
@@ -122,13 +297,26 @@ class SellCSigma {
 
   */
   void rebuild(kkLidView new_element, kkLidView new_particle_elements = kkLidView(), 
-                  MemberTypeViews<DataTypes> new_particles = NULL);
+                  MemberTypeViews<DataTypes> new_particles = MemberTypeViews<DataTypes>());
+  /*
+    Rebuilds a new SCS and orders the particles of each element by a key
+    sort_key - functor/lambda taking the particle id (lid_t ptcl_id) and returning a non
+               negative lid_t key, e.g. a Morton code of the position in the element.
+               Particles with equal keys keep the order of their ids and new particles
+               follow the sorted particles of their element.
+    The structure is always rebuilt, a reshuffle would not order the particles.
+  */
+  template <typename KeyFunction>
+  void rebuild(kkLidView new_element, KeyFunction& sort_key,
+               kkLidView new_particle_elements = kkLidView(),
+               MemberTypeViews<DataTypes> new_particles = MemberTypeViews<DataTypes>());
 
   /*
     Performs a parallel for over the elements/particles in the SCS
-    The passed in functor/lambda should take in 3 arguments (int elm_id, int ptcl_id, bool mask)
+    The passed in functor/lambda should take in 3 arguments (lid_t elm_id, lid_t ptcl_id,
+    bool mask) where lid_t is the local index type of the structure
     Example usage with lambda:
-    auto lamb = SCS_LAMBDA(const int& elm_id, const int& ptcl_id, const bool& mask) {
+    auto lamb = SCS_LAMBDA(const lid_t& elm_id, const lid_t& ptcl_id, const bool& mask) {
       do stuff...
     };
     scs->parallel_for(lamb);
@@ -136,6 +324,32 @@ class SellCSigma {
   template <typename FunctionType>
   void parallel_for(FunctionType& fn, std::string s="");
 
+  /*
+    Performs a parallel for over every slot of the SCS with a flat range policy
+    Takes the same functor/lambda as parallel_for. The element of each slot is read from
+    the stored slot elements, falls back to parallel_for when they are not stored.
+  */
+  template <typename FunctionType>
+  void parallel_for_flat(FunctionType& fn, std::string s="");
+
+  /*
+    Performs a parallel for over the particles of the SCS skipping the empty slots
+    Takes the same functor/lambda as parallel_for, the mask is always set. The particles
+    are read from the list of active slots, when it is not kept the functor is called from
+    parallel_for for the slots with a particle.
+  */
+  template <typename FunctionType>
+  void parallel_for_active(FunctionType& fn, std::string s="");
+
+  /*
+    Performs a parallel for over the elements/particles in the SCS passing the row of
+    each slot so the element arrays can be read by row
+    The passed in functor/lambda should take in 4 arguments (lid_t elm_id, lid_t row,
+    lid_t ptcl_id, bool mask) where row is the entry of the element in the element arrays
+  */
+  template <typename FunctionType>
+  void parallel_for_rows(FunctionType& fn, std::string s="");
+
 
   //Prints the format of the SCS labeled by prefix
   void printFormat(const char* prefix = "") const;
@@ -144,16 +358,79 @@ class SellCSigma {
   void printMetrics() const;
   
   //Do not call these functions:
+  void sortRows(kkLidView row_sizes, PairView<ExecSpace>& ptcls, lid_t& new_C);
   void constructChunks(PairView<ExecSpace> ptcls, lid_t& nchunks,
                        kkLidView& chunk_widths, kkLidView& row_element,
                        kkLidView& element_row);
   void createGlobalMapping(kkGidView elmGid, kkGidView& elm2Gid, GID_Mapping& elmGid2Lid);
   void constructOffsets(lid_t nChunks, lid_t& nSlices, kkLidView chunk_widths, 
                         kkLidView& offs, kkLidView& s2e, lid_t& capacity);
-  void setupParticleMask(kkLidView mask, PairView<ExecSpace> ptcls, kkLidView chunk_widths);
-  void initSCSData(kkLidView chunk_widths, kkLidView particle_elements,
+  void constructElementRows(PairView<ExecSpace> ptcls, lid_t nRows, kkLidView& elem_row_offs,
+                            kkLidView& elem_rows, kkLidView& row_widths);
+  void constructOverflow(kkLidView ptcls_per_elem, kkLidView row_sizes, lid_t& nOverflow,
+                         kkLidView& overflow_offs, kkLidView& overflow_elems);
+  void setupParticleMask(ParticleMask<ExecSpace, lid_t> mask, PairView<ExecSpace> ptcls,
+                         kkLidView chunk_widths);
+  void initSCSData(kkLidView chunk_widths, kkLidView row_widths, kkLidView particle_elements,
                    MemberTypeViews<DataTypes> particle_info);
+  bool regrowChunks(kkLidView new_particles_per_row, kkLidView num_holes_per_row);
+  void reserveColdEntries(lid_t num_new_ptcls);
+  //Rounds n entries up to whole tiles so every component of the last tile is allocated
+  static std::size_t wholeTiles(std::size_t n, lid_t tile) {
+    return tile > 0 ? (n + tile - 1) / tile * tile : n;
+  }
+  void addColdParticles(kkLidView index, kkLidView new_particle_slots,
+                        MemberTypeViews<DataTypes> new_particles);
+  void updateSlotElements();
+  void updateActiveSlots();
+  kkLidView elementEntrySources(kkLidView row_elem, lid_t nrows, bool rowless);
+  //Copies fn to the device for a kernel launch, freeDeviceFunction releases the copy
+  template <typename FunctionType>
+  static FunctionType* deviceFunction(FunctionType& fn);
+  template <typename FunctionType>
+  static void freeDeviceFunction(FunctionType* fn_d);
+  //Calls fn(elm_id, row, ptcl_id, mask) on every slot of the chunks and the overflow region
+  template <typename RowFunction>
+  void parallel_for_slots(RowFunction fn, std::string name);
+  //Rebuilds with the particles ordered by ptcl_keys in each element (empty for any order)
+  void rebuildWithKeys(kkLidView new_element, kkLidView new_particle_elements,
+                       MemberTypeViews<DataTypes> new_particles, kkLidView ptcl_keys);
+  //Ranks the particles moving to each element by key and counts them in elem_fill
+  kkLidView rankParticles(kkLidView new_element, kkLidView ptcl_keys, kkLidView elem_fill);
+  /* Phases of migrate, the species of a group run them in one communication round
+     The particles sent to or received from each process are counted in
+     num_send(process * nspecies + species) and num_recv(process * nspecies + species)
+  */
+  void countMigration(kkLidView new_process, kkLidView num_send, int nspecies, int species);
+  void packMigration(kkLidView new_element, kkLidView new_process, kkLidView num_send,
+                     kkLidView num_recv, int nspecies, int species, MigrationBuffers& buffers);
+  /* The particles of a species travel in one part of the message to or from each process,
+     their element gids followed by each member, migrationEntryBytes bytes per particle
+     packMessages copies the particles sent to each process into send_bytes from
+     send_starts[process], unpackMessages copies the particles received from each process
+     out of recv_bytes from recv_starts[process]
+  */
+  static std::size_t migrationEntryBytes() {return sizeof(gid_t) + DataTypes::memsize;}
+  void packMessages(MigrationBuffers& buffers, kkByteView send_bytes,
+                    const std::vector<std::size_t>& send_starts) {
+    copyMessages(buffers.send_offsets, buffers.send_element, buffers.send_particle,
+                 send_bytes, send_starts, true);
+  }
+  void unpackMessages(MigrationBuffers& buffers, kkByteView recv_bytes,
+                      const std::vector<std::size_t>& recv_starts) {
+    copyMessages(buffers.recv_offsets, buffers.recv_element, buffers.recv_particle,
+                 recv_bytes, recv_starts, false);
+  }
+  void copyMessages(kkLidHostMirror offsets, kkGidView elements,
+                    MemberTypeViews<DataTypes> particles, kkByteView bytes,
+                    const std::vector<std::size_t>& starts, bool pack);
+  void finishMigration(kkLidView new_element, kkLidView new_process,
+                       MigrationBuffers& buffers);
 private:
+  //Shallow copies of the structure for snapshot and restore
+  SellCSigma(const SellCSigma&) = default;
+  SellCSigma& operator=(const SellCSigma&) = default;
+
   //Number of Data types
   static constexpr std::size_t num_types = DataTypes::size;
 
@@ -173,24 +450,42 @@ private:
   lid_t num_slices;
   //Total entries
   lid_t num_elems;
+  //num_elems + the number of padded rows which are given ids after the elements
+  lid_t num_element_ids;
   //Total particles
   lid_t num_ptcls;
   //num_ptcls + buffer
   lid_t capacity_;
+  //Number of overflow slots stored after the chunks at [capacity_ - num_overflow, capacity_)
+  lid_t num_overflow;
   //chunk_element stores the id of the first row in the chunk
   //  This only matters for vertical slicing so that each slice can determine which row
   //  it is a part of.
   kkLidView slice_to_chunk;
-  //particle_mask true means there is a particle at this location, false otherwise
-  kkLidView particle_mask;
+  //particle_mask bit set means there is a particle at this location, unset otherwise
+  ParticleMask<ExecSpace, lid_t> particle_mask;
   //offsets into the scs structure
   kkLidView offsets;
 
   //map from row to element
   // row = slice_to_chunk[slice] + row_in_chunk
   kkLidView row_to_element;
-  //map from element to row
+  //map from element to one of its rows (-1 for elements without a row)
   kkLidView element_to_row;
+  //CSR of the rows of each element, elements are split across several rows when
+  //  the capacity policy splits heavy rows
+  kkLidView element_row_offsets;
+  kkLidView element_rows;
+  //Sigma sort of the rows by the last sortRows, rebuild repairs it when few counts change
+  //  (empty when the rows of the elements are split or skipped)
+  PairView<ExecSpace> sorted_rows;
+  //elements in the order the sigma windows are formed (empty for the order of the ids)
+  kkLidView element_order;
+
+  //CSR offsets of each element into the overflow region (size num_elems + 1)
+  kkLidView overflow_offsets;
+  //element of each overflow slot
+  kkLidView overflow_to_element;
 
   //mappings from row to element gid and back to row
   kkGidView element_to_gid;
@@ -203,15 +498,67 @@ private:
 
   //True - try shuffling every rebuild, false - only rebuild
   bool tryShuffling;
+  //True - members are stored in tiles of C slots, false - native view layout
+  bool tileMembers;
+  //True - rebuild without the swap copy of the members, false - double buffered rebuild
+  bool inPlaceRebuild;
+  //True - reshuffle grows the overfull chunks, false - reshuffle falls back to rebuild
+  bool localRegrowth;
+  //Bit mask of the members that stay in place during rebuild and reshuffle
+  unsigned int cold_members;
+  //Rebuilds between permutations of the cold members (0 only on demand) and the count so far
+  int cold_interval, cold_rebuilds;
+  //True - cold entries are reached through cold_index, false - they are in slot order
+  bool coldIndexed;
+  //Entry of the cold members for each slot
+  kkLidView cold_index;
+  //Cold entries in use, entries allocated for the cold members and their tile height
+  lid_t cold_used;
+  std::size_t cold_size;
+  lid_t cold_tile;
+  //True - slot_to_element holds the element of each slot, false - it is not stored
+  bool slotElements;
+  kkLidView slot_to_element;
+  //True - active_slots lists the slots with a particle and active_elements their elements
+  bool activeSlots;
+  kkLidView active_slots;
+  kkLidView active_elements;
+  //Per element data in row order
+  std::vector<ElementArrayBase<kkLidView>*> element_arrays;
+  //True - some elements have no row and their element array entries follow the rows
+  bool rowlessElements;
+  //Permutes the cold members once every cold_interval rebuilds
+  void countColdRebuild() {
+    if (cold_members && cold_interval > 0 && ++cold_rebuilds >= cold_interval)
+      permuteColdMembers();
+  }
+  //Number of particles in each element
+  kkLidView particles_per_element;
+  //Bit mask of the member views shared with a snapshot, they are copied before a write
+  unsigned int shared_members;
+  //True - the particle mask, the element counts and the cold index are shared with a snapshot
+  bool sharedLayout;
+  //Copies the selected member views that are shared with a snapshot
+  void unshareMembers(unsigned int members);
+  //Copies the layout views that are updated in place when they are shared
+  void unshareLayout();
+  /* Drops the swap views after the members in replaced were swapped out of scs_data,
+     the swapped out views may be shared with a snapshot
+  */
+  void releaseSharedSwap(unsigned int replaced);
+  //Adds the change in the particles of each element from a reshuffle
+  void addOccupancyChange(kkLidView change);
+  //Over allocation, shrinking and row slack settings
+  CapacityPolicy capacity_policy;
   //Metric Info
   lid_t num_empty_elements;
 };
 
-template<typename ExecSpace>
-int chooseChunkHeight(int maxC,
-                      Kokkos::View<lid_t*, typename ExecSpace::device_type> ptcls_per_elem) {
-  lid_t num_elems_with_ptcls = 0;
-  Kokkos::parallel_reduce("count_elems", ptcls_per_elem.size(), KOKKOS_LAMBDA(const lid_t& i, lid_t& sum) {
+template<typename ExecSpace, typename LidView>
+int chooseChunkHeight(int maxC, LidView ptcls_per_elem) {
+  typedef typename LidView::non_const_value_type Lid;
+  Lid num_elems_with_ptcls = 0;
+  Kokkos::parallel_reduce("count_elems", ptcls_per_elem.size(), KOKKOS_LAMBDA(const Lid& i, Lid& sum) {
     sum += ptcls_per_elem(i) > 0;
     }, num_elems_with_ptcls);
   if (num_elems_with_ptcls == 0)
@@ -220,54 +567,408 @@ int chooseChunkHeight(int maxC,
     return num_elems_with_ptcls;
   return maxC;
 }
-template <typename ExecSpace> 
-void sigmaSort(PairView<ExecSpace>& ptcl_pairs, lid_t num_elems, 
-               Kokkos::View<lid_t*,typename ExecSpace::device_type> ptcls_per_elem, 
-               lid_t sigma){
+/* Stable radix sort of ids by the keys of key(id) in [0, max_key]
+   Each pass sorts 8 bits of the key, so a key of b bits takes ceil(b/8) passes. The ids are
+   split in blocks that each count their digits, the counts are scanned digit by digit and
+   block by block to give each block the first index of each of its digits, and every block
+   then scatters its ids in order. All the passes run in the memory of the execution space.
+   Ids with the same key keep their order, sorting by a second key after the first sorts by
+   the second then the first.
+*/
+template <typename ExecSpace, typename IndexView, typename KeyFn>
+void radixSortIds(IndexView& ids, KeyFn key, typename IndexView::non_const_value_type max_key) {
+  typedef typename IndexView::non_const_value_type Index;
+  constexpr int digit_bits = 8;
+  constexpr Index num_digits = 1 << digit_bits;
+  const Index block_size = 1024;
+  const Index num_ids = ids.size();
+  int bits = 0;
+  while (bits < 8 * static_cast<int>(sizeof(Index)) - 1 && (max_key >> bits) > 0)
+    ++bits;
+  const Index num_blocks = (num_ids + block_size - 1) / block_size;
+  IndexView sorted_ids("sorted_ids", num_ids);
+  IndexView digit_counts("radix_digit_counts", num_digits * num_blocks);
+  IndexView digit_offsets("radix_digit_offsets", num_digits * num_blocks + 1);
+  for (int shift = 0; shift < bits; shift += digit_bits) {
+    IndexView ids_local = ids;
+    //The counts are stored digit major so the scan orders the ids by digit then by block
+    Kokkos::parallel_for("radix_count", num_blocks, KOKKOS_LAMBDA(const Index& b) {
+      for (Index d = 0; d < num_digits; ++d)
+        digit_counts(d * num_blocks + b) = 0;
+      const Index end = (b + 1) * block_size < num_ids ? (b + 1) * block_size : num_ids;
+      for (Index i = b * block_size; i < end; ++i)
+        ++digit_counts(((key(ids_local(i)) >> shift) & (num_digits - 1)) * num_blocks + b);
+    });
+    Kokkos::parallel_scan("radix_offsets", num_digits * num_blocks,
+                          KOKKOS_LAMBDA(const Index& i, Index& cur, const bool& final) {
+      cur += digit_counts(i);
+      if (final)
+        digit_offsets(i+1) = cur;
+    });
+    Kokkos::parallel_for("radix_scatter", num_blocks, KOKKOS_LAMBDA(const Index& b) {
+      Index next[num_digits];
+      for (Index d = 0; d < num_digits; ++d)
+        next[d] = digit_offsets(d * num_blocks + b);
+      const Index end = (b + 1) * block_size < num_ids ? (b + 1) * block_size : num_ids;
+      for (Index i = b * block_size; i < end; ++i) {
+        const Index id = ids_local(i);
+        sorted_ids(next[(key(id) >> shift) & (num_digits - 1)]++) = id;
+      }
+    });
+    ids = sorted_ids;
+    sorted_ids = ids_local;
+  }
+}
+
+//Radix keys of the elements by decreasing count and by sigma window of their rank
+template <typename LidView>
+struct SigmaCountKey {
+  typedef typename LidView::non_const_value_type Index;
+  LidView counts;
+  Index max_count;
+  KOKKOS_INLINE_FUNCTION Index operator()(Index id) const {return max_count - counts(id);}
+};
+template <typename LidView>
+struct SigmaWindowKey {
+  typedef typename LidView::non_const_value_type Index;
+  LidView ranks;
+  Index sigma;
+  KOKKOS_INLINE_FUNCTION Index operator()(Index id) const {return ranks(id) / sigma;}
+};
+template <typename LidView>
+struct ElementKey {
+  LidView keys;
+  typedef typename LidView::non_const_value_type Index;
+  KOKKOS_INLINE_FUNCTION Index operator()(Index id) const {return keys(id);}
+};
+
+//Moves ids(begin + root) down the heap of the first size ids by keys(id) and then by id
+template <typename IndexView, typename KeyView>
+KOKKOS_INLINE_FUNCTION void siftDownIds(IndexView ids, KeyView keys,
+                                        typename IndexView::non_const_value_type begin,
+                                        typename IndexView::non_const_value_type root,
+                                        typename IndexView::non_const_value_type size) {
+  typedef typename IndexView::non_const_value_type Index;
+  while (2 * root + 1 < size) {
+    Index child = 2 * root + 1;
+    const Index a = ids(begin + child);
+    if (child + 1 < size) {
+      const Index b = ids(begin + child + 1);
+      if (keys(a) < keys(b) || (keys(a) == keys(b) && a < b))
+        ++child;
+    }
+    const Index top = ids(begin + root);
+    const Index big = ids(begin + child);
+    if (keys(big) < keys(top) || (keys(big) == keys(top) && big < top))
+      return;
+    ids(begin + root) = big;
+    ids(begin + child) = top;
+    root = child;
+  }
+}
+
+/* Sorts ids(begin:end) by keys(id) and then by id on one thread
+   Heap sort needs no scratch memory, so each element of a rebuild sorts its own particles
+   in parallel with the other elements in O(k log k) for k particles.
+*/
+template <typename IndexView, typename KeyView>
+KOKKOS_INLINE_FUNCTION void heapSortIds(IndexView ids, KeyView keys,
+                                        typename IndexView::non_const_value_type begin,
+                                        typename IndexView::non_const_value_type end) {
+  typedef typename IndexView::non_const_value_type Index;
+  const Index n = end - begin;
+  for (Index root = n / 2; root-- > 0;)
+    siftDownIds(ids, keys, begin, root, n);
+  for (Index last = n - 1; last > 0; --last) {
+    const Index top = ids(begin);
+    ids(begin) = ids(begin + last);
+    ids(begin + last) = top;
+    siftDownIds(ids, keys, begin, Index(0), last);
+  }
+}
+
+/* Returns the rank of each element in the order (element_order(r) is the element of rank r)
+   An empty order ranks the elements by id
+*/
+template <typename ExecSpace, typename LidView>
+Kokkos::View<typename LidView::non_const_value_type*, typename ExecSpace::device_type>
+elementRanks(typename LidView::non_const_value_type num_elems, LidView element_order) {
+  typedef typename LidView::non_const_value_type Lid;
+  Kokkos::View<Lid*, typename ExecSpace::device_type> ranks("element_ranks", num_elems);
+  const bool ordered = element_order.size() > 0;
+  Kokkos::parallel_for("element_ranks", num_elems, KOKKOS_LAMBDA(const Lid& r) {
+    ranks(ordered ? element_order(r) : r) = r;
+  });
+  return ranks;
+}
+
+/* Sorts the ids of the elements by sigma window of their rank and decreasing count
+   ids - the element ids in the order of their rank
+*/
+template <typename ExecSpace, typename IndexView, typename LidView, typename RankView>
+void sortSigmaIds(IndexView& ids, typename LidView::non_const_value_type num_elems,
+                  LidView ptcls_per_elem, RankView ranks,
+                  typename LidView::non_const_value_type sigma) {
+  typedef typename LidView::non_const_value_type Lid;
+  Lid max_count = 0;
+  Kokkos::parallel_reduce("sigma_max_count", ids.size(),
+                          KOKKOS_LAMBDA(const Lid& i, Lid& mx) {
+    if (ptcls_per_elem(ids(i)) > mx)
+      mx = ptcls_per_elem(ids(i));
+  }, Kokkos::Max<Lid, ExecSpace>(max_count));
+  const Lid num_windows = num_elems / sigma + (num_elems % sigma != 0);
+  radixSortIds<ExecSpace>(ids, SigmaCountKey<LidView>{ptcls_per_elem, max_count}, max_count);
+  radixSortIds<ExecSpace>(ids, SigmaWindowKey<RankView>{ranks, sigma}, num_windows - 1);
+}
+
+/* Sorts the elements by particle count within windows of sigma elements
+   ptcl_pairs - (count, element) of each sorted element
+   element_order - the elements in the order the windows are formed (optional), by default
+                   the windows hold consecutive element ids. Elements with the same count
+                   keep this order.
+*/
+template <typename ExecSpace, typename LidView> 
+void sigmaSort(PairView<ExecSpace>& ptcl_pairs, typename LidView::non_const_value_type num_elems,
+               LidView ptcls_per_elem, typename LidView::non_const_value_type sigma,
+               LidView element_order = LidView()){
+  typedef typename LidView::non_const_value_type Lid;
   //Make temporary copy of the particle counts for sorting
   ptcl_pairs = PairView<ExecSpace>("ptcl_pairs", num_elems);
+  const bool ordered = element_order.size() > 0;
   //PairView<ExecSpace> ptcl_pairs("ptcl_pairs", num_elems);
   if (sigma > 1) {
-    lid_t i;
 #ifdef SCS_USE_CUDA
-    Kokkos::View<lid_t*, typename ExecSpace::device_type> elem_ids("elem_ids", num_elems);
-    Kokkos::View<lid_t*, typename ExecSpace::device_type> temp_ppe("temp_ppe", num_elems);
-    Kokkos::parallel_for(num_elems, KOKKOS_LAMBDA(const lid_t& i) {
-      temp_ppe(i) = ptcls_per_elem(i);
-      elem_ids(i) = i;
+    Lid i;
+    Kokkos::View<Lid*, typename ExecSpace::device_type> elem_ids("elem_ids", num_elems);
+    Kokkos::View<Lid*, typename ExecSpace::device_type> temp_ppe("temp_ppe", num_elems);
+    //Negated counts sorted stably give decreasing counts with ties in the order of the ranks
+    //  like the host sort, sigmaResort relies on the same order on every backend
+    Kokkos::parallel_for(num_elems, KOKKOS_LAMBDA(const Lid& i) {
+      const Lid elem = ordered ? element_order(i) : i;
+      temp_ppe(i) = -ptcls_per_elem(elem);
+      elem_ids(i) = elem;
     });
-    thrust::device_ptr<lid_t> ptcls_t(temp_ppe.data());
-    thrust::device_ptr<lid_t> elem_ids_t(elem_ids.data());
+    thrust::device_ptr<Lid> ptcls_t(temp_ppe.data());
+    thrust::device_ptr<Lid> elem_ids_t(elem_ids.data());
     for (i = 0; i < num_elems - sigma; i+=sigma) {
-      thrust::sort_by_key(thrust::device, ptcls_t + i, ptcls_t + i + sigma, elem_ids_t + i);
+      thrust::stable_sort_by_key(thrust::device, ptcls_t + i, ptcls_t + i + sigma,
+                                 elem_ids_t + i);
     }
-    thrust::sort_by_key(thrust::device, ptcls_t + i, ptcls_t + num_elems, elem_ids_t + i);
-    Kokkos::parallel_for(num_elems, KOKKOS_LAMBDA(const lid_t& i) {
-      ptcl_pairs(num_elems - 1 - i).first = temp_ppe(i);
-      ptcl_pairs(num_elems - 1 - i).second = elem_ids(i);
+    thrust::stable_sort_by_key(thrust::device, ptcls_t + i, ptcls_t + num_elems, elem_ids_t + i);
+    Kokkos::parallel_for(num_elems, KOKKOS_LAMBDA(const Lid& i) {
+      ptcl_pairs(i).first = -temp_ppe(i);
+      ptcl_pairs(i).second = elem_ids(i);
     });
 #else
-    Kokkos::parallel_for(num_elems, KOKKOS_LAMBDA(const lid_t& i) {
-      ptcl_pairs(num_elems).first = ptcls_per_elem(i);
-      ptcl_pairs(num_elems).second = i;
+    Kokkos::View<Lid*, typename ExecSpace::device_type> ids("sigma_ids", num_elems);
+    Kokkos::parallel_for("sigma_init_ids", num_elems, KOKKOS_LAMBDA(const Lid& i) {
+      ids(i) = ordered ? element_order(i) : i;
+    });
+    sortSigmaIds<ExecSpace>(ids, num_elems, ptcls_per_elem,
+                            elementRanks<ExecSpace>(num_elems, element_order), sigma);
+    Kokkos::parallel_for("sigma_set_pairs", num_elems, KOKKOS_LAMBDA(const Lid& i) {
+      ptcl_pairs(i).first = ptcls_per_elem(ids(i));
+      ptcl_pairs(i).second = ids(i);
     });
-    typename PairView<ExecSpace>::HostMirror ptcl_pairs_host = deviceToHost(ptcl_pairs);
-    MyPair* ptcl_pair_data = ptcl_pairs_host.data();
-    for (i = 0; i < num_elems - sigma; i+=sigma) {
-      std::sort(ptcl_pair_data + i, ptcl_pair_data + i + sigma);
-    }
-    std::sort(ptcl_pair_data + i, ptcl_pair_data + num_elems);
-    hostToDevice(ptcl_pairs,  ptcl_pair_data);
 #endif
   }
   else {
-    Kokkos::parallel_for(num_elems, KOKKOS_LAMBDA(const lid_t& i) {
-      ptcl_pairs(i).first = ptcls_per_elem(i);
-      ptcl_pairs(i).second = i;
+    Kokkos::parallel_for(num_elems, KOKKOS_LAMBDA(const Lid& i) {
+      const Lid elem = ordered ? element_order(i) : i;
+      ptcl_pairs(i).first = ptcls_per_elem(elem);
+      ptcl_pairs(i).second = elem;
     });
   }
 }
 
+//Returns true when the element of rank a comes before the element of rank b in sigmaSort
+template <typename Lid>
+KOKKOS_INLINE_FUNCTION bool sigmaBefore(Lid count_a, Lid rank_a, Lid count_b, Lid rank_b,
+                                        Lid sigma) {
+  if (rank_a / sigma != rank_b / sigma)
+    return rank_a / sigma < rank_b / sigma;
+  if (count_a != count_b)
+    return count_a > count_b;
+  return rank_a < rank_b;
+}
+
+/* Repairs a previous sigmaSort of the same elements after the counts of some changed
+   prev_pairs - the result of sigmaSort for the previous counts and the same element_order,
+                it is repaired in place and shared by ptcl_pairs
+   Window w always holds the elements of ranks [w*sigma, (w+1)*sigma) at the same positions,
+   so only the windows with a changed count are touched. In those windows the unchanged
+   entries are still in order, the changed elements are radix sorted and then merged with
+   them by binary search. Apart from one pass over the counts to find the changes, the
+   work and memory traffic scale with the number of entries in the changed windows.
+   Returns false without sorting when the previous sort cannot be reused or when too
+   many counts changed for the repair to be cheaper than sigmaSort
+*/
+template <typename ExecSpace, typename LidView>
+bool sigmaResort(PairView<ExecSpace>& ptcl_pairs, PairView<ExecSpace> prev_pairs,
+                 typename LidView::non_const_value_type num_elems, LidView ptcls_per_elem,
+                 typename LidView::non_const_value_type sigma,
+                 LidView element_order = LidView()) {
+  typedef typename LidView::non_const_value_type Lid;
+  typedef Kokkos::View<Lid*, typename ExecSpace::device_type> IndexView;
+  if (sigma <= 1 || prev_pairs.size() != static_cast<std::size_t>(num_elems))
+    return false;
+  const Lid num_windows = num_elems / sigma + (num_elems % sigma != 0);
+  IndexView window_changes("sigma_window_changes", num_windows);
+  Lid num_changed = 0;
+  Kokkos::parallel_reduce("sigma_find_changes", num_elems,
+                          KOKKOS_LAMBDA(const Lid& i, Lid& sum) {
+    if (ptcls_per_elem(prev_pairs(i).second) != prev_pairs(i).first) {
+      Kokkos::atomic_fetch_add(&window_changes(i / sigma), 1);
+      ++sum;
+    }
+  }, num_changed);
+  if (num_changed == 0) {
+    ptcl_pairs = prev_pairs;
+    return true;
+  }
+  if (num_changed * 4 > num_elems)
+    return false;
+
+  //List the positions of the entries of the changed windows, which are also their ranks
+  IndexView dirty_offsets("sigma_dirty_offsets", num_windows + 1);
+  Kokkos::parallel_scan("sigma_dirty_offsets", num_windows,
+                        KOKKOS_LAMBDA(const Lid& w, Lid& cur, const bool& final) {
+    const Lid size = num_elems - w * sigma < sigma ? num_elems - w * sigma : sigma;
+    cur += size * (window_changes(w) > 0);
+    if (final)
+      dirty_offsets(w+1) = cur;
+  });
+  const Lid num_dirty = getLastValue<Lid>(dirty_offsets);
+  IndexView dirty_positions("sigma_dirty_positions", num_dirty);
+  Kokkos::parallel_for("sigma_dirty_positions", num_dirty, KOKKOS_LAMBDA(const Lid& j) {
+    Lid lo = 0, hi = num_windows - 1;
+    while (lo < hi) {
+      const Lid mid = (lo + hi + 1) / 2;
+      if (dirty_offsets(mid) <= j)
+        lo = mid;
+      else
+        hi = mid - 1;
+    }
+    dirty_positions(j) = lo * sigma + j - dirty_offsets(lo);
+  });
+
+  //Flag and rank the elements of the changed windows, the other entries are never read
+  const bool ordered = element_order.size() > 0;
+  IndexView changed(Kokkos::ViewAllocateWithoutInitializing("sigma_changed"), num_elems);
+  IndexView ranks(Kokkos::ViewAllocateWithoutInitializing("sigma_ranks"), num_elems);
+  Kokkos::parallel_for("sigma_flag_changes", num_dirty, KOKKOS_LAMBDA(const Lid& j) {
+    const Lid p = dirty_positions(j);
+    const Lid elem = prev_pairs(p).second;
+    changed(elem) = ptcls_per_elem(elem) != prev_pairs(p).first;
+    ranks(ordered ? element_order(p) : p) = p;
+  });
+  IndexView kept_offsets("sigma_kept_offsets", num_dirty + 1);
+  Kokkos::parallel_scan("sigma_kept_offsets", num_dirty,
+                        KOKKOS_LAMBDA(const Lid& j, Lid& cur, const bool& final) {
+    cur += !changed(prev_pairs(dirty_positions(j)).second);
+    if (final)
+      kept_offsets(j+1) = cur;
+  });
+  IndexView changed_offsets("sigma_changed_offsets", num_dirty + 1);
+  Kokkos::parallel_scan("sigma_changed_offsets", num_dirty,
+                        KOKKOS_LAMBDA(const Lid& j, Lid& cur, const bool& final) {
+    const Lid r = dirty_positions(j);
+    cur += changed(ordered ? element_order(r) : r);
+    if (final)
+      changed_offsets(j+1) = cur;
+  });
+  const Lid num_kept = num_dirty - num_changed;
+
+  //Sort the changed elements in the order of their ranks
+  IndexView changed_ids("sigma_changed_ids", num_changed);
+  IndexView kept_ids("sigma_kept_ids", num_kept);
+  Kokkos::parallel_for("sigma_split_changes", num_dirty, KOKKOS_LAMBDA(const Lid& j) {
+    const Lid p = dirty_positions(j);
+    const Lid ranked = ordered ? element_order(p) : p;
+    if (changed(ranked))
+      changed_ids(changed_offsets(j)) = ranked;
+    const Lid elem = prev_pairs(p).second;
+    if (!changed(elem))
+      kept_ids(kept_offsets(j)) = elem;
+  });
+  sortSigmaIds<ExecSpace>(changed_ids, num_elems, ptcls_per_elem, ranks, sigma);
+
+  //Merge the sorted changed elements with the kept entries of the changed windows
+  ptcl_pairs = prev_pairs;
+  Kokkos::parallel_for("sigma_merge_kept", num_kept, KOKKOS_LAMBDA(const Lid& i) {
+    const Lid elem = kept_ids(i);
+    const Lid count = ptcls_per_elem(elem);
+    Lid lo = 0, hi = num_changed;
+    while (lo < hi) {
+      const Lid mid = (lo + hi) / 2;
+      const Lid other = changed_ids(mid);
+      if (sigmaBefore(ptcls_per_elem(other), ranks(other), count, ranks(elem), sigma))
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    const Lid p = dirty_positions(i + lo);
+    prev_pairs(p).first = count;
+    prev_pairs(p).second = elem;
+  });
+  Kokkos::parallel_for("sigma_merge_changed", num_changed, KOKKOS_LAMBDA(const Lid& i) {
+    const Lid elem = changed_ids(i);
+    const Lid count = ptcls_per_elem(elem);
+    Lid lo = 0, hi = num_kept;
+    while (lo < hi) {
+      const Lid mid = (lo + hi) / 2;
+      const Lid other = kept_ids(mid);
+      if (sigmaBefore(ptcls_per_elem(other), ranks(other), count, ranks(elem), sigma))
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    const Lid p = dirty_positions(i + lo);
+    prev_pairs(p).first = count;
+    prev_pairs(p).second = elem;
+  });
+  return true;
+}
+
+/* Returns the Morton (Z-order) index of each element from its centroid
+   The centroids are quantized to 10 bits per axis over their bounding box, so elements
+   that are close in space get close indices. Use as the keys of setElementOrder.
+   centroids - the centroid of each element (num_elems x 3)
+*/
+template <typename ExecSpace, typename RealView>
+Kokkos::View<lid_t*, typename ExecSpace::device_type> mortonKeys(RealView centroids) {
+  typedef typename RealView::non_const_value_type Point;
+  typedef typename std::remove_extent<Point>::type Real;
+  const lid_t num_elems = centroids.extent(0);
+  Real lo[3], hi[3];
+  for (int d = 0; d < 3; ++d) {
+    Kokkos::parallel_reduce("morton_min", num_elems, KOKKOS_LAMBDA(const lid_t& i, Real& mn) {
+      if (centroids(i, d) < mn)
+        mn = centroids(i, d);
+    }, Kokkos::Min<Real, ExecSpace>(lo[d]));
+    Kokkos::parallel_reduce("morton_max", num_elems, KOKKOS_LAMBDA(const lid_t& i, Real& mx) {
+      if (centroids(i, d) > mx)
+        mx = centroids(i, d);
+    }, Kokkos::Max<Real, ExecSpace>(hi[d]));
+  }
+  const Real x0 = lo[0], y0 = lo[1], z0 = lo[2];
+  const Real dx = hi[0] > lo[0] ? hi[0] - lo[0] : 1;
+  const Real dy = hi[1] > lo[1] ? hi[1] - lo[1] : 1;
+  const Real dz = hi[2] > lo[2] ? hi[2] - lo[2] : 1;
+  Kokkos::View<lid_t*, typename ExecSpace::device_type> keys("morton_keys", num_elems);
+  Kokkos::parallel_for("morton_keys", num_elems, KOKKOS_LAMBDA(const lid_t& i) {
+    const lid_t cells[3] = {static_cast<lid_t>((centroids(i, 0) - x0) / dx * 1023),
+                            static_cast<lid_t>((centroids(i, 1) - y0) / dy * 1023),
+                            static_cast<lid_t>((centroids(i, 2) - z0) / dz * 1023)};
+    lid_t key = 0;
+    for (int b = 9; b >= 0; --b)
+      for (int d = 0; d < 3; ++d)
+        key = (key << 1) | ((cells[d] >> b) & 1);
+    keys(i) = key;
+  });
+  return keys;
+}
+
 template <typename ExecSpace>
 struct MaxChunkWidths {
 
@@ -305,26 +1006,113 @@ struct MaxChunkWidths {
   }
 };
 
-template<class DataTypes, typename ExecSpace> 
-void SellCSigma<DataTypes, ExecSpace>::constructChunks(PairView<ExecSpace> ptcls, lid_t& nchunks, 
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::sortRows(kkLidView row_sizes, PairView<ExecSpace>& ptcls,
+                                                lid_t& new_C) {
+  const bool split = capacity_policy.hasSplitRows();
+  const bool skip_empty = capacity_policy.skip_empty;
+  if (!split && !skip_empty) {
+    new_C = FixedC > 0 ? FixedC : chooseChunkHeight<ExecSpace>(C_max, row_sizes);
+    if (!sigmaResort<ExecSpace>(ptcls, sorted_rows, num_elems, row_sizes, sigma,
+                                element_order))
+      sigmaSort<ExecSpace>(ptcls, num_elems, row_sizes, sigma, element_order);
+    sorted_rows = ptcls;
+    return;
+  }
+  //Split each heavy element into rows of nearly equal size no wider than max_width
+  //  and drop the empty elements when they are skipped, the entries follow the element order
+  const lid_t max_width = capacity_policy.max_row_width;
+  const bool ordered = element_order.size() > 0;
+  kkLidView element_order_local = element_order;
+  kkLidView entry_offsets("entry_offsets", num_elems + 1);
+  Kokkos::parallel_scan(num_elems, KOKKOS_LAMBDA(const lid_t& i, lid_t& cur, const bool& final) {
+    const lid_t size = row_sizes(ordered ? element_order_local(i) : i);
+    if (size == 0)
+      cur += !skip_empty;
+    else if (split && size > max_width)
+      cur += (size + max_width - 1) / max_width;
+    else
+      cur += 1;
+    if (final)
+      entry_offsets(i+1) = cur;
+  });
+  const lid_t num_entries = getLastValue<lid_t>(entry_offsets);
+  kkLidView entry_sizes("entry_sizes", num_entries);
+  kkLidView entry_elements("entry_elements", num_entries);
+  Kokkos::parallel_for(num_elems, KOKKOS_LAMBDA(const lid_t& i) {
+    const lid_t start = entry_offsets(i);
+    const lid_t pieces = entry_offsets(i+1) - start;
+    const lid_t elem = ordered ? element_order_local(i) : i;
+    const lid_t size = row_sizes(elem);
+    for (lid_t j = 0; j < pieces; ++j) {
+      entry_sizes(start + j) = size / pieces + (j < size % pieces);
+      entry_elements(start + j) = elem;
+    }
+  });
+  new_C = FixedC > 0 ? FixedC : chooseChunkHeight<ExecSpace>(C_max, entry_sizes);
+  sigmaSort<ExecSpace>(ptcls, num_entries, entry_sizes, sigma);
+  sorted_rows = PairView<ExecSpace>();
+  Kokkos::parallel_for(num_entries, KOKKOS_LAMBDA(const lid_t& i) {
+    ptcls(i).second = entry_elements(ptcls(i).second);
+  });
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::constructElementRows(PairView<ExecSpace> ptcls,
+                                                            lid_t nRows,
+                                                            kkLidView& elem_row_offs,
+                                                            kkLidView& elem_rows,
+                                                            kkLidView& row_widths) {
+  const lid_t nentries = ptcls.size();
+  row_widths = kkLidView("row_widths", nRows);
+  kkLidView rows_per_elem("rows_per_elem", num_elems);
+  Kokkos::parallel_for(nentries, KOKKOS_LAMBDA(const lid_t& i) {
+    row_widths(i) = ptcls(i).first;
+    Kokkos::atomic_fetch_add(&rows_per_elem(ptcls(i).second), 1);
+  });
+  elem_row_offs = kkLidView("element_row_offsets", num_elems + 1);
+  Kokkos::parallel_scan(num_elems, KOKKOS_LAMBDA(const lid_t& i, lid_t& cur, const bool& final) {
+    cur += rows_per_elem(i);
+    if (final)
+      elem_row_offs(i+1) = cur;
+  });
+  elem_rows = kkLidView("element_rows", nentries);
+  kkLidView fill("fill", num_elems);
+  Kokkos::parallel_for(nentries, KOKKOS_LAMBDA(const lid_t& i) {
+    const lid_t elem = ptcls(i).second;
+    elem_rows(elem_row_offs(elem) + Kokkos::atomic_fetch_add(&fill(elem), 1)) = i;
+  });
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType> 
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::constructChunks(PairView<ExecSpace> ptcls, lid_t& nchunks, 
                                                        kkLidView& chunk_widths,
                                                        kkLidView& row_element,
                                                        kkLidView& element_row) {
-  nchunks = num_elems / C_ + (num_elems % C_ != 0);
+  //Each sorted entry is a row, elements that are split appear in several rows
+  //  and skipped elements in none
+  const lid_t nrows = ptcls.size();
+  nchunks = nrows / C_ + (nrows % C_ != 0);
   chunk_widths = kkLidView("chunk_widths", nchunks);
   row_element = kkLidView("row_element", nchunks * C_);
-  element_row = kkLidView("element_row", nchunks * C_);
-  kkLidView empty("empty_elems", 1);
+  //Padded rows are given the ids after the elements
+  const lid_t pad_id = num_elems - nrows;
+  element_row = kkLidView("element_row", num_elems + nchunks * C_ - nrows);
   Kokkos::parallel_for(num_elems, KOKKOS_LAMBDA(const lid_t& i) {
+    element_row(i) = -1;
+  });
+  kkLidView empty("empty_elems", 1);
+  Kokkos::parallel_for(nrows, KOKKOS_LAMBDA(const lid_t& i) {
     const lid_t element = ptcls(i).second;
     row_element(i) = element;
+    //Split elements keep any one of their rows
     element_row(element) = i;
     Kokkos::atomic_fetch_add(&empty[0], ptcls(i).first == 0);
   });
-  Kokkos::parallel_for(Kokkos::RangePolicy<>(num_elems, nchunks * C_),
+  Kokkos::parallel_for(Kokkos::RangePolicy<ExecSpace>(nrows, nchunks * C_),
                        KOKKOS_LAMBDA(const lid_t& i) {
-    row_element(i) = i;
-    element_row(i) = i;
+    row_element(i) = pad_id + i;
+    element_row(pad_id + i) = i;
     Kokkos::atomic_fetch_add(&empty[0], 1);
   });
 
@@ -332,12 +1120,11 @@ void SellCSigma<DataTypes, ExecSpace>::constructChunks(PairView<ExecSpace> ptcls
   typedef Kokkos::TeamPolicy<ExecSpace> team_policy;
   const team_policy policy(nchunks, C_);
   lid_t C_local = C_;
-  lid_t num_elems_local = num_elems;
   Kokkos::parallel_for(policy, KOKKOS_LAMBDA(const typename team_policy::member_type& thread) {
     const lid_t chunk_id = thread.league_rank();
     const lid_t row_num = chunk_id * C_local + thread.team_rank();
     lid_t width = 0;
-    if (row_num < num_elems_local) {
+    if (row_num < nrows) {
       width = ptcls(row_num).first;
     }
     thread.team_reduce(Kokkos::Max<lid_t,ExecSpace>(width));
@@ -345,30 +1132,32 @@ void SellCSigma<DataTypes, ExecSpace>::constructChunks(PairView<ExecSpace> ptcls
   });
 }
 
-template<class DataTypes, typename ExecSpace>
-void SellCSigma<DataTypes, ExecSpace>::createGlobalMapping(kkGidView elmGid,kkGidView& elm2Gid, 
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::createGlobalMapping(kkGidView elmGid,kkGidView& elm2Gid, 
                                                            GID_Mapping& elmGid2Lid) {
-  elm2Gid = kkGidView("row to element gid", numRows());
+  elm2Gid = kkGidView("row to element gid", numElementIds());
   Kokkos::parallel_for(num_elems, KOKKOS_LAMBDA(const lid_t& i) {
     const gid_t gid = elmGid(i);
     elm2Gid(i) = gid;
     elmGid2Lid.insert(gid, i);
   });
-  Kokkos::parallel_for(Kokkos::RangePolicy<>(num_elems, numRows()), KOKKOS_LAMBDA(const lid_t& i) {
+  Kokkos::parallel_for(Kokkos::RangePolicy<ExecSpace>(num_elems, numElementIds()),
+                       KOKKOS_LAMBDA(const lid_t& i) {
     elm2Gid(i) = -1;
   });
 }
 
-template<class DataTypes, typename ExecSpace>
-void SellCSigma<DataTypes, ExecSpace>::constructOffsets(lid_t nChunks, lid_t& nSlices, 
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::constructOffsets(lid_t nChunks, lid_t& nSlices, 
                                                         kkLidView chunk_widths, kkLidView& offs,
                                                         kkLidView& s2c, lid_t& cap) {
   kkLidView slices_per_chunk("slices_per_chunk", nChunks);
   const lid_t V_local = V_;
   Kokkos::parallel_for(nChunks, KOKKOS_LAMBDA(const lid_t& i) {
+    const lid_t V = sliceWidth(V_local);
     const lid_t width = chunk_widths(i);
-    const lid_t val1 = width / V_local;
-    const lid_t val2 = width % V_local;
+    const lid_t val1 = width / V;
+    const lid_t val2 = width % V;
     const bool val3 = val2 != 0;
     slices_per_chunk(i) = val1 + val3;
   });
@@ -386,15 +1175,16 @@ void SellCSigma<DataTypes, ExecSpace>::constructOffsets(lid_t nChunks, lid_t& nS
   const lid_t nat_size = V_*C_;
   const lid_t C_local = C_;
   Kokkos::parallel_for(nChunks, KOKKOS_LAMBDA(const lid_t& i) {
+    const lid_t V = sliceWidth(V_local);
     const lid_t start = offset_nslices(i);
     const lid_t end = offset_nslices(i+1);
     for (lid_t j = start; j < end; ++j) {
       s2c(j) = i;
-      const lid_t rem = chunk_widths(i) % V_local;
-      const lid_t val = rem + (rem==0)*V_local;
+      const lid_t rem = chunk_widths(i) % V;
+      const lid_t val = rem + (rem==0)*V;
       const bool is_last = (j == end-1);
       slice_size(j) = (!is_last) * nat_size;
-      slice_size(j) += (is_last) * (val) * C_local;
+      slice_size(j) += (is_last) * (val) * chunkHeight(C_local);
     }
   });
   Kokkos::parallel_scan(nSlices, KOKKOS_LAMBDA(const lid_t& i, lid_t& cur, const bool final) {
@@ -406,8 +1196,30 @@ void SellCSigma<DataTypes, ExecSpace>::constructOffsets(lid_t nChunks, lid_t& nS
   });
   cap = getLastValue<lid_t>(offs);
 }
-template<class DataTypes, typename ExecSpace>
-void SellCSigma<DataTypes, ExecSpace>::setupParticleMask(kkLidView mask, PairView<ExecSpace> ptcls, kkLidView chunk_widths) {
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::constructOverflow(kkLidView ptcls_per_elem,
+                                                         kkLidView row_sizes, lid_t& nOverflow,
+                                                         kkLidView& overflow_offs,
+                                                         kkLidView& overflow_elems) {
+  overflow_offs = kkLidView("overflow_offsets", num_elems + 1);
+  Kokkos::parallel_scan(num_elems, KOKKOS_LAMBDA(const lid_t& i, lid_t& cur, const bool& final) {
+    const lid_t spill = ptcls_per_elem(i) - row_sizes(i);
+    cur += spill * (spill > 0);
+    if (final)
+      overflow_offs(i+1) = cur;
+  });
+  nOverflow = getLastValue<lid_t>(overflow_offs);
+  overflow_elems = kkLidView("overflow_to_element", nOverflow);
+  Kokkos::parallel_for(num_elems, KOKKOS_LAMBDA(const lid_t& i) {
+    for (lid_t j = overflow_offs(i); j < overflow_offs(i+1); ++j)
+      overflow_elems(j) = i;
+  });
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::setupParticleMask(ParticleMask<ExecSpace, lid_t> mask,
+                                                         PairView<ExecSpace> ptcls,
+                                                         kkLidView chunk_widths) {
   //Get start of each chunk
   auto offsets_cpy = offsets;
   auto slice_to_chunk_cpy = slice_to_chunk;
@@ -431,20 +1243,22 @@ void SellCSigma<DataTypes, ExecSpace>::setupParticleMask(kkLidView mask, PairVie
     const lid_t chunk_row = thread.team_rank();
     const lid_t rowLen = chunk_widths(chunk);
     const lid_t start = chunk_starts(chunk) + chunk_row;
-    Kokkos::parallel_for(Kokkos::TeamThreadRange(thread, team_size), [=] (lid_t& j) {
-      const lid_t row = chunk * team_size + chunk_row;
+    const lid_t C = chunkHeight(team_size);
+    Kokkos::parallel_for(Kokkos::TeamThreadRange(thread, C), [=] (lid_t& j) {
+      const lid_t row = chunk * C + chunk_row;
       const lid_t element_id = row_to_element_cpy(row);
       Kokkos::parallel_for(Kokkos::ThreadVectorRange(thread, rowLen), [&] (lid_t& p) {
-        const lid_t particle_id = start+(p*team_size);
-        if (element_id < ne)
-          mask(particle_id) =  p < ptcls(row).first;
+        const lid_t particle_id = start+(p*C);
+        if (element_id < ne && p < ptcls(row).first)
+          mask.set(particle_id);
       });
     });
   });
 \
 }
-template<class DataTypes, typename ExecSpace>
-void SellCSigma<DataTypes, ExecSpace>::initSCSData(kkLidView chunk_widths,
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::initSCSData(kkLidView chunk_widths,
+                                                   kkLidView row_widths,
                                                    kkLidView particle_elements,
                                                    MemberTypeViews<DataTypes> particle_info) {
   lid_t given_particles = particle_elements.size();
@@ -459,54 +1273,95 @@ void SellCSigma<DataTypes, ExecSpace>::initSCSData(kkLidView chunk_widths,
       }
       sum += chunk_widths(i) * C_local;
     });
-  //Determine index for each particle
+  //Determine index for each particle, filling the rows before the overflow region
+  kkLidView elem_fill("elem_fill", num_elems);
+  kkLidView element_row_offsets_local = element_row_offsets;
+  kkLidView element_rows_local = element_rows;
+  kkLidView overflow_offsets_local = overflow_offsets;
+  const lid_t overflow_start = capacity_ - num_overflow;
   kkLidView particle_indices("new_particle_scs_indices", given_particles);
   Kokkos::parallel_for(given_particles, KOKKOS_LAMBDA(const lid_t& i) {
       lid_t new_elem = particle_elements(i);
-      lid_t new_row = element_to_row_local(new_elem);
-      particle_indices(i) = Kokkos::atomic_fetch_add(&row_index(new_row), C_local);
+      const lid_t k = Kokkos::atomic_fetch_add(&elem_fill(new_elem), 1);
+      particle_indices(i) = elementSlot(k, new_elem, element_row_offsets_local,
+                                        element_rows_local, row_widths, row_index, C_local,
+                                        overflow_start + overflow_offsets_local(new_elem));
     });
   
-  CopyNewParticlesToSCS<SellCSigma<DataTypes, ExecSpace>, DataTypes>(this, scs_data,
-                                                                     particle_info,
-                                                                     given_particles,
-                                                                     particle_indices);
+  CopyNewParticlesToSCS<SellCSigma, DataTypes>(this, scs_data,
+                                               tileHeight(),
+                                               particle_info,
+                                               given_particles,
+                                               particle_indices);
 }
 
-template<class DataTypes, typename ExecSpace>
-SellCSigma<DataTypes, ExecSpace>::SellCSigma(PolicyType& p, lid_t sig, lid_t v, lid_t ne, 
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::SellCSigma(PolicyType& p, lid_t sig, lid_t v, lid_t ne, 
                                              lid_t np, kkLidView ptcls_per_elem, 
                                              kkGidView element_gids,
                                              kkLidView particle_elements,
-                                             MemberTypeViews<DataTypes> particle_info) :
-  policy(p), element_gid_to_lid(ne) {
+                                             MemberTypeViews<DataTypes> particle_info,
+                                             CapacityPolicy cap_policy) :
+  policy(p), element_gid_to_lid(ne), capacity_policy(cap_policy) {
   Kokkos::Profiling::pushRegion("scs_construction");
   tryShuffling = true;
+  tileMembers = false;
+  inPlaceRebuild = false;
+  localRegrowth = false;
+  cold_members = 0;
+  cold_interval = cold_rebuilds = 0;
+  coldIndexed = false;
+  cold_used = cold_tile = 0;
+  cold_size = 0;
+  slotElements = false;
+  activeSlots = false;
+  shared_members = 0;
+  sharedLayout = false;
   int comm_size;
   MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
   int comm_rank;
   MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
 
   C_max = policy.team_size();
-  C_ = chooseChunkHeight<ExecSpace>(C_max, ptcls_per_elem);
+  //Kernels launch teams of FixedC threads, which the policy must allow
+  PS_ALWAYS_ASSERT(FixedC == 0 || FixedC <= C_max);
   
   sigma = sig;
-  V_ = v;
+  V_ = sliceWidth(v);
   num_elems = ne;
   num_ptcls = np;
+  particles_per_element = kkLidView("particles_per_element", num_elems);
+  kkLidView particles_per_element_local = particles_per_element;
+  Kokkos::parallel_for("set_particles_per_element", num_elems, KOKKOS_LAMBDA(const lid_t& i) {
+    particles_per_element_local(i) = ptcls_per_elem(i);
+  });
 
-  if(!comm_rank)
-    fprintf(stderr, "Building SCS with C: %d sigma: %d V: %d\n",C_,sigma,V_);
+  //Cap the row sizes so heavy elements spill into the overflow region
+  kkLidView row_sizes = ptcls_per_elem;
+  if (capacity_policy.hasOverflow()) {
+    row_sizes = kkLidView("row_sizes", ptcls_per_elem.size());
+    const lid_t max_width = capacity_policy.max_row_width;
+    Kokkos::parallel_for("cap_rows", row_sizes.size(), KOKKOS_LAMBDA(const lid_t& i) {
+      row_sizes(i) = capRowSize(ptcls_per_elem(i), max_width);
+    });
+  }
   //Perform sorting
   PairView<ExecSpace> ptcls;
   Kokkos::Timer timer;
-  sigmaSort<ExecSpace>(ptcls, num_elems,ptcls_per_elem, sigma);
+  sortRows(row_sizes, ptcls, C_);
+  rowlessElements = capacity_policy.skip_empty;
+  if(!comm_rank)
+    fprintf(stderr, "Building SCS with C: %ld sigma: %ld V: %ld\n", (long)C_, (long)sigma,
+            (long)V_);
   if(comm_rank == 0 || comm_rank == comm_size/2)
     fprintf(stderr,"%d SCS sorting time (seconds) %f\n", comm_rank, timer.seconds());
 
   // Number of chunks without vertical slicing
   kkLidView chunk_widths;
   constructChunks(ptcls, num_chunks, chunk_widths, row_to_element, element_to_row);
+  kkLidView row_widths;
+  constructElementRows(ptcls, numRows(), element_row_offsets, element_rows, row_widths);
+  num_element_ids = num_elems + numRows() - ptcls.size();
 
   if (element_gids.size() > 0) {
     createGlobalMapping(element_gids, element_to_gid, element_gid_to_lid);
@@ -515,36 +1370,287 @@ SellCSigma<DataTypes, ExecSpace>::SellCSigma(PolicyType& p, lid_t sig, lid_t v,
   //Create offsets into each chunk/vertical slice
   constructOffsets(num_chunks, num_slices, chunk_widths, offsets, slice_to_chunk,capacity_);
 
-  //Allocate the SCS and backup with 10% extra space
-  lid_t cap = getLastValue<lid_t>(offsets);
-  particle_mask = kkLidView("particle_mask", cap);
-  CreateViews<DataTypes>(scs_data, cap*1.1);
-  CreateViews<DataTypes>(scs_data_swap, cap*1.1);
-  swap_size = current_size = cap*1.1;
-
-  if (np > 0)
+  //Place the particles beyond the capped row sizes after the chunks
+  constructOverflow(ptcls_per_elem, row_sizes, num_overflow, overflow_offsets,
+                    overflow_to_element);
+  const lid_t overflow_start = capacity_;
+  capacity_ += num_overflow;
+
+  //Allocate the SCS and backup with the extra space of the capacity policy
+  //  The overflow region is padded to a full tile of C slots
+  lid_t cap = overflow_start + (num_overflow + C_ - 1) / C_ * C_;
+  particle_mask = ParticleMask<ExecSpace, lid_t>("particle_mask", capacity_);
+  swap_size = current_size = capacity_policy.allocation(cap);
+  scs_data = createMemberViews<DataTypes>(current_size);
+  scs_data_swap = createMemberViews<DataTypes>(swap_size);
+
+  if (np > 0) {
     setupParticleMask(particle_mask, ptcls, chunk_widths);
+    //Every overflow slot holds a particle after construction
+    auto particle_mask_local = particle_mask;
+    Kokkos::parallel_for("overflow_mask", num_overflow, KOKKOS_LAMBDA(const lid_t& i) {
+      particle_mask_local.set(overflow_start + i);
+    });
+  }
 
   //If particle info is provided then enter the information
   lid_t given_particles = particle_elements.size();
-  if (given_particles > 0 && particle_info != NULL) {
-    initSCSData(chunk_widths, particle_elements, particle_info);
+  if (given_particles > 0 && particle_info.isAllocated()) {
+    initSCSData(chunk_widths, row_widths, particle_elements, particle_info);
   }
   Kokkos::Profiling::popRegion();
 }
 
-template<class DataTypes, typename ExecSpace>
-void SellCSigma<DataTypes, ExecSpace>::destroy() {
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::setSlotElements(bool store) {
+  slotElements = store;
+  if (store)
+    updateSlotElements();
+  else
+    slot_to_element = kkLidView();
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::setActiveSlots(bool store) {
+  activeSlots = store;
+  if (store)
+    updateActiveSlots();
+  else {
+    active_slots = kkLidView();
+    active_elements = kkLidView();
+  }
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::setElementOrder(kkLidView element_keys) {
+  //The previous sort was formed from the old order
+  sorted_rows = PairView<ExecSpace>();
+  if (element_keys.size() == 0) {
+    element_order = kkLidView();
+    return;
+  }
+  PS_ALWAYS_ASSERT(element_keys.size() == static_cast<std::size_t>(num_elems));
+  lid_t max_key = 0;
+  lid_t min_key = 0;
+  Kokkos::parallel_reduce("max_element_key", num_elems, KOKKOS_LAMBDA(const lid_t& i, lid_t& mx) {
+    if (element_keys(i) > mx)
+      mx = element_keys(i);
+  }, Kokkos::Max<lid_t, ExecSpace>(max_key));
+  Kokkos::parallel_reduce("min_element_key", num_elems, KOKKOS_LAMBDA(const lid_t& i, lid_t& mn) {
+    if (element_keys(i) < mn)
+      mn = element_keys(i);
+  }, Kokkos::Min<lid_t, ExecSpace>(min_key));
+  PS_ALWAYS_ASSERT(min_key >= 0);
+  element_order = kkLidView("element_order", num_elems);
+  kkLidView element_order_local = element_order;
+  Kokkos::parallel_for("init_element_order", num_elems, KOKKOS_LAMBDA(const lid_t& i) {
+    element_order_local(i) = i;
+  });
+  radixSortIds<ExecSpace>(element_order, ElementKey<kkLidView>{element_keys}, max_key);
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::updateActiveSlots() {
+  if (!activeSlots)
+    return;
+  active_slots = kkLidView("active_slots", num_ptcls);
+  active_elements = kkLidView("active_elements", num_ptcls);
+  kkLidView active_slots_local = active_slots;
+  kkLidView active_elements_local = active_elements;
+  //Position of each particle in the list
+  kkLidView slot_position("slot_position", capacity_);
+  auto particle_mask_local = particle_mask;
+  Kokkos::parallel_scan("active_slots", capacity_,
+                        KOKKOS_LAMBDA(const lid_t& i, lid_t& cur, const bool& final) {
+    const bool mask = particle_mask_local(i);
+    if (final && mask) {
+      active_slots_local(cur) = i;
+      slot_position(i) = cur;
+    }
+    cur += mask;
+  });
+  auto setActiveElement = SCS_LAMBDA(const lid_t& element_id, const lid_t& particle_id,
+                                     const bool& mask) {
+    if (mask)
+      active_elements_local(slot_position(particle_id)) = element_id;
+  };
+  parallel_for(setActiveElement, "setActiveElement");
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+typename SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::kkLidView
+SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::elementEntrySources(kkLidView row_elem,
+                                                                           lid_t nrows,
+                                                                           bool rowless) {
+  //Element of each entry of the element arrays, -1 for the padded rows
+  const lid_t nentries = nrows + rowless * num_elems;
+  kkLidView sources("element_entry_sources", nentries);
+  const lid_t ne = num_elems;
+  Kokkos::parallel_for("element_entry_sources", nentries, KOKKOS_LAMBDA(const lid_t& i) {
+    if (i < nrows) {
+      const lid_t elem = row_elem(i);
+      sources(i) = elem < ne ? elem : -1;
+    }
+    else
+      sources(i) = i - nrows;
+  });
+  return sources;
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+template <typename T>
+int SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::addElementArray(MemberTypeView<T> values) {
+  ElementArray<T, kkLidView>* array = new ElementArray<T, kkLidView>(values);
+  array->permute(elementEntrySources(row_to_element, numRows(), rowlessElements));
+  element_arrays.push_back(array);
+  return element_arrays.size() - 1;
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+template <typename T>
+MemberTypeView<T> SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::getElementArray(int id) const {
+  ElementArray<T, kkLidView>* array =
+    dynamic_cast<ElementArray<T, kkLidView>*>(element_arrays[id]);
+  PS_ALWAYS_ASSERT(array != NULL);
+  return array->view;
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::updateSlotElements() {
+  if (!slotElements)
+    return;
+  slot_to_element = kkLidView("slot_to_element", capacity_);
+  kkLidView slot_to_element_local = slot_to_element;
+  auto setSlotElement = SCS_LAMBDA(const lid_t& element_id, const lid_t& particle_id,
+                                   const bool& mask) {
+    slot_to_element_local(particle_id) = element_id;
+  };
+  parallel_for(setSlotElement, "setSlotElement");
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::setMemberTiling(bool tiled) {
+  if (tiled == tileMembers)
+    return;
+  permuteColdMembers();
+  const lid_t old_tile = tileHeight();
+  tileMembers = tiled;
+  if (capacity_ == 0)
+    return;
+  if (inPlaceRebuild) {
+    RetileViewsInPlace<DataTypes>(scs_data, tileHeight(), old_tile, capacity_, current_size);
+    shared_members = 0;
+    return;
+  }
+  //Relayout the members into the swap views and then swap the views
+  if (swap_size < current_size) {
+    destroyViews<DataTypes>(scs_data_swap);
+    scs_data_swap = createMemberViews<DataTypes>(current_size);
+    swap_size = current_size;
+  }
+  RetileViews<DataTypes>(scs_data_swap, tileHeight(), scs_data, old_tile, capacity_);
+  MemberTypeViews<DataTypes> tmp = scs_data;
+  scs_data = scs_data_swap;
+  scs_data_swap = tmp;
+  std::size_t tmp_size = current_size;
+  current_size = swap_size;
+  swap_size = tmp_size;
+  releaseSharedSwap(all_members);
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>*
+SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::snapshot() {
+  SellCSigma* snap = new SellCSigma(*this);
+  //The snapshot allocates its own swap views at its first rebuild
+  snap->scs_data_swap = MemberTypeViews<DataTypes>();
+  snap->swap_size = 0;
+  for (std::size_t i = 0; i < element_arrays.size(); ++i)
+    snap->element_arrays[i] = element_arrays[i]->copy();
+  shared_members = snap->shared_members = all_members;
+  sharedLayout = snap->sharedLayout = true;
+  return snap;
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::restore(SellCSigma* snap) {
+  for (std::size_t i = 0; i < element_arrays.size(); ++i)
+    delete element_arrays[i];
+  //The swap views of the structure are never shared with the snapshot, keep them
+  MemberTypeViews<DataTypes> swap = scs_data_swap;
+  const std::size_t old_swap_size = swap_size;
+  *this = *snap;
+  scs_data_swap = swap;
+  swap_size = old_swap_size;
+  for (std::size_t i = 0; i < element_arrays.size(); ++i)
+    element_arrays[i] = snap->element_arrays[i]->copy();
+  shared_members = snap->shared_members = all_members;
+  sharedLayout = snap->sharedLayout = true;
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::unshareMembers(
+                                                                 unsigned int members) {
+  const unsigned int copied = shared_members & members;
+  if (!copied)
+    return;
+  copyMemberViews(scs_data, copied);
+  shared_members &= ~copied;
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::unshareLayout() {
+  if (!sharedLayout)
+    return;
+  ParticleMask<ExecSpace, lid_t> new_particle_mask("particle_mask", particle_mask.size());
+  Kokkos::deep_copy(new_particle_mask.wordView(), particle_mask.wordView());
+  particle_mask = new_particle_mask;
+  kkLidView new_particles_per_element("particles_per_element", num_elems);
+  Kokkos::deep_copy(new_particles_per_element, particles_per_element);
+  particles_per_element = new_particles_per_element;
+  if (coldIndexed) {
+    kkLidView new_cold_index("cold_index", cold_index.size());
+    Kokkos::deep_copy(new_cold_index, cold_index);
+    cold_index = new_cold_index;
+  }
+  sharedLayout = false;
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::releaseSharedSwap(
+                                                                 unsigned int replaced) {
+  if (shared_members & replaced) {
+    destroyViews<DataTypes>(scs_data_swap);
+    swap_size = 0;
+  }
+  shared_members &= ~replaced;
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::setInPlaceRebuild(bool inPlace) {
+  inPlaceRebuild = inPlace;
+  //The swap views are recreated by the next rebuild when double buffering is turned back on
+  if (inPlace && scs_data_swap.isAllocated()) {
+    destroyViews<DataTypes>(scs_data_swap);
+    swap_size = 0;
+  }
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::destroy() {
   destroyViews<DataTypes>(scs_data);
   destroyViews<DataTypes>(scs_data_swap);
+  for (std::size_t i = 0; i < element_arrays.size(); ++i)
+    delete element_arrays[i];
+  element_arrays.clear();
 }
-template<class DataTypes, typename ExecSpace>
-SellCSigma<DataTypes, ExecSpace>::~SellCSigma() {
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::~SellCSigma() {
   destroy();
 }
 
-template<class DataTypes, typename ExecSpace>
-void SellCSigma<DataTypes, ExecSpace>::migrate(kkLidView new_element, kkLidView new_process) {
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::migrate(kkLidView new_element, kkLidView new_process) {
   const auto btime = prebarrier();
   Kokkos::Profiling::pushRegion("scs_migrate");
   Kokkos::Timer timer;
@@ -562,11 +1668,7 @@ void SellCSigma<DataTypes, ExecSpace>::migrate(kkLidView new_element, kkLidView
     return;
   }
   kkLidView num_send_particles("num_send_particles", comm_size);
-  auto count_sending_particles = SCS_LAMBDA(lid_t element_id, lid_t particle_id, bool mask) {
-    const lid_t process = new_process(particle_id);
-    Kokkos::atomic_fetch_add(&(num_send_particles(process)), mask * (process != comm_rank));
-  };
-  parallel_for(count_sending_particles);
+  countMigration(new_process, num_send_particles, 1, 0);
   kkLidView num_recv_particles("num_recv_particles", comm_size);
   PS_Comm_Alltoall(num_send_particles, 1, num_recv_particles, 1, MPI_COMM_WORLD);
 
@@ -586,31 +1688,92 @@ void SellCSigma<DataTypes, ExecSpace>::migrate(kkLidView new_element, kkLidView
     return;
   }
   /********** Send particle information to new processes **********/
-  //Perform an ex-sum on num_send_particles & num_recv_particles
+  MigrationBuffers buffers;
+  packMigration(new_element, new_process, num_send_particles, num_recv_particles, 1, 0,
+                buffers);
+  //One message to and from each neighbor holds all the members of its particles
+  std::vector<std::size_t> send_starts(comm_size + 1), recv_starts(comm_size + 1);
+  for (int i = 0; i <= comm_size; ++i) {
+    send_starts[i] = buffers.send_offsets(i) * migrationEntryBytes();
+    recv_starts[i] = buffers.recv_offsets(i) * migrationEntryBytes();
+  }
+  kkByteView send_bytes("send_bytes", send_starts[comm_size]);
+  kkByteView recv_bytes("recv_bytes", recv_starts[comm_size]);
+  packMessages(buffers, send_bytes, send_starts);
+  MPI_Request* send_requests = new MPI_Request[comm_size];
+  MPI_Request* recv_requests = new MPI_Request[comm_size];
+  int num_sends, num_recvs;
+  PS_Comm_Messages(send_bytes, send_starts, recv_bytes, recv_starts, 0, MPI_COMM_WORLD,
+                   send_requests, num_sends, recv_requests, num_recvs);
+  PS_Comm_Waitall<ExecSpace>(num_recvs, recv_requests, MPI_STATUSES_IGNORE);
+  delete [] recv_requests;
+  unpackMessages(buffers, recv_bytes, recv_starts);
+
+  /********** Combine and shift particles to their new destination **********/
+  finishMigration(new_element, new_process, buffers);
+
+  //Cleanup
+  PS_Comm_Waitall<ExecSpace>(num_sends, send_requests, MPI_STATUSES_IGNORE);
+  delete [] send_requests;
+  destroyViews<DataTypes>(buffers.send_particle);
+  destroyViews<DataTypes>(buffers.recv_particle);
+  if(!comm_rank || comm_rank == comm_size/2)
+    fprintf(stderr, "%d ps particle migration (seconds) %f pre-barrier (seconds) %f\n",
+        comm_rank, timer.seconds(), btime);
+  Kokkos::Profiling::popRegion();
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::countMigration(
+                                                                 kkLidView new_process,
+                                                                 kkLidView num_send,
+                                                                 int nspecies, int species) {
+  int comm_rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
+  auto count_sending_particles = SCS_LAMBDA(lid_t element_id, lid_t particle_id, bool mask) {
+    const lid_t process = new_process(particle_id);
+    Kokkos::atomic_fetch_add(&(num_send(process * nspecies + species)),
+                             mask * (process != comm_rank));
+  };
+  parallel_for(count_sending_particles);
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::packMigration(
+                                                                 kkLidView new_element,
+                                                                 kkLidView new_process,
+                                                                 kkLidView num_send,
+                                                                 kkLidView num_recv,
+                                                                 int nspecies, int species,
+                                                                 MigrationBuffers& buffers) {
+  int comm_size;
+  MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
+  int comm_rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
+  //Perform an ex-sum on num_send & num_recv of this species
   kkLidView offset_send_particles("offset_send_particles", comm_size+1);
   kkLidView offset_send_particles_temp("offset_send_particles_temp", comm_size + 1);
   kkLidView offset_recv_particles("offset_recv_particles", comm_size+1);
   Kokkos::parallel_scan(comm_size, KOKKOS_LAMBDA(const lid_t& i, lid_t& num, const bool& final) {
-    num += num_send_particles(i);
+    num += num_send(i * nspecies + species);
     if (final) {
       offset_send_particles(i+1) += num;
       offset_send_particles_temp(i+1) += num;
     }
   });
   Kokkos::parallel_scan(comm_size, KOKKOS_LAMBDA(const lid_t& i, lid_t& num, const bool& final) {
-    num += num_recv_particles(i);
+    num += num_recv(i * nspecies + species);
     if (final)
       offset_recv_particles(i+1) += num;
   });
-  kkLidHostMirror offset_send_particles_host = deviceToHost(offset_send_particles);
-  kkLidHostMirror offset_recv_particles_host = deviceToHost(offset_recv_particles);
+  buffers.send_offsets = deviceToHost(offset_send_particles);
+  buffers.recv_offsets = deviceToHost(offset_recv_particles);
 
   //Create arrays for particles being sent
-  lid_t np_send = offset_send_particles_host(comm_size);
-  kkLidView send_element("send_element", np_send);
-  MemberTypeViews<DataTypes> send_particle;
-  //Allocate views for each data type into send_particle[type]
-  CreateViews<DataTypes>(send_particle, np_send);
+  lid_t np_send = buffers.send_offsets(comm_size);
+  kkGidView send_element("send_element", np_send);
+  //Allocate views for each data type into send_particle
+  buffers.send_particle = createMemberViews<DataTypes>(np_send);
   kkLidView send_index("send_particle_index", capacity());
   auto element_to_gid_local = element_to_gid;
   auto gatherParticlesToSend = SCS_LAMBDA(lid_t element_id, lid_t particle_id, lid_t mask) {
@@ -623,59 +1786,55 @@ void SellCSigma<DataTypes, ExecSpace>::migrate(kkLidView new_element, kkLidView
     }
   };
   parallel_for(gatherParticlesToSend);
-  //Copy the values from scs_data[type][particle_id] into send_particle[type](index) for each data type
-  CopyParticlesToSend<SellCSigma<DataTypes, ExecSpace>, DataTypes>(this, send_particle, scs_data,
-                                                                   new_process,
-                                                                   send_index);
+  buffers.send_element = send_element;
+  permuteColdMembers();
+  //Copy the values from scs_data(particle_id) into send_particle(index) for each data type
+  CopyParticlesToSend<SellCSigma, DataTypes>(this, buffers.send_particle, scs_data,
+                                             new_process,
+                                             send_index);
   
   //Create arrays for particles being received
-  lid_t np_recv = offset_recv_particles_host(comm_size);
-  kkLidView recv_element("recv_element", np_recv);
-  MemberTypeViews<DataTypes> recv_particle;
-  //Allocate views for each data type into recv_particle[type]
-  CreateViews<DataTypes>(recv_particle, np_recv);
-
-  //Get pointers to the data for MPI calls
-  lid_t send_num = 0, recv_num = 0;
-  lid_t num_sends = num_sending_to * (num_types + 1);
-  lid_t num_recvs = num_receiving_from * (num_types + 1);
-  MPI_Request* send_requests = new MPI_Request[num_sends];
-  MPI_Request* recv_requests = new MPI_Request[num_recvs];
-  //Send the particles to each neighbor
-  for (lid_t i = 0; i < comm_size; ++i) {
-    if (i == comm_rank)
+  lid_t np_recv = buffers.recv_offsets(comm_size);
+  buffers.recv_element = kkGidView("recv_element", np_recv);
+  //Allocate views for each data type into recv_particle
+  buffers.recv_particle = createMemberViews<DataTypes>(np_recv);
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::copyMessages(
+                                                          kkLidHostMirror offsets,
+                                                          kkGidView elements,
+                                                          MemberTypeViews<DataTypes> particles,
+                                                          kkByteView bytes,
+                                                          const std::vector<std::size_t>& starts,
+                                                          bool pack) {
+  const int nprocs = offsets.size() - 1;
+  for (int i = 0; i < nprocs; ++i) {
+    const lid_t num_ptcls = offsets(i+1) - offsets(i);
+    if (num_ptcls == 0)
       continue;
-    
-    //Sending
-    lid_t num_send = offset_send_particles_host(i+1) - offset_send_particles_host(i);
-    if (num_send > 0) {
-      lid_t start_index = offset_send_particles_host(i);
-      PS_Comm_Isend(send_element, start_index, num_send, i, 0, MPI_COMM_WORLD, 
-                    send_requests +send_num);
-      send_num++;
-      SendViews<DataTypes>(send_particle, start_index, num_send, i, 1,
-                           send_requests + send_num);
-      send_num+=num_types;
-    }
-    //Receiving
-    lid_t num_recv = offset_recv_particles_host(i+1) - offset_recv_particles_host(i);
-    if (num_recv > 0) {
-      lid_t start_index = offset_recv_particles_host(i);
-      PS_Comm_Irecv(recv_element, start_index, num_recv, i, 0, MPI_COMM_WORLD, 
-                    recv_requests + recv_num);
-      recv_num++;
-      RecvViews<DataTypes>(recv_particle,start_index, num_recv, i, 1,
-                           recv_requests + recv_num);
-      recv_num+=num_types;
-    }
+    const std::size_t element_bytes = num_ptcls * sizeof(gid_t);
+    MessageBytes message(bytes.data() + starts[i], num_ptcls * migrationEntryBytes());
+    copyEntryBytes<gid_t>(elements, offsets(i), num_ptcls, message, pack);
+    copyMemberBytes(particles, offsets(i), num_ptcls,
+                    MessageBytes(message.data() + element_bytes, message.size() - element_bytes),
+                    pack);
   }
-  PS_Comm_Waitall<ExecSpace>(num_recvs, recv_requests, MPI_STATUSES_IGNORE);
-  delete [] recv_requests;
+}
 
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::finishMigration(
+                                                                 kkLidView new_element,
+                                                                 kkLidView new_process,
+                                                                 MigrationBuffers& buffers) {
+  int comm_rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
   /********** Convert the received element from element gid to element lid *********/
   auto element_gid_to_lid_local = element_gid_to_lid;
+  kkGidView recv_element_gid = buffers.recv_element;
+  kkLidView recv_element("recv_element_lid", recv_element_gid.size());
   Kokkos::parallel_for(recv_element.size(), KOKKOS_LAMBDA(const lid_t& i) {
-    const gid_t gid = recv_element(i);
+    const gid_t gid = recv_element_gid(i);
     const lid_t index = element_gid_to_lid_local.find(gid);
     recv_element(i) = element_gid_to_lid_local.value_at(index);
   });
@@ -690,28 +1849,24 @@ void SellCSigma<DataTypes, ExecSpace>::migrate(kkLidView new_element, kkLidView
   parallel_for(removeSentParticles);
 
   /********** Combine and shift particles to their new destination **********/
-  rebuild(new_element, recv_element, recv_particle);
-
-  //Cleanup
-  PS_Comm_Waitall<ExecSpace>(num_sends, send_requests, MPI_STATUSES_IGNORE);
-  delete [] send_requests;
-  destroyViews<DataTypes>(send_particle);
-  destroyViews<DataTypes>(recv_particle);
-  if(!comm_rank || comm_rank == comm_size/2)
-    fprintf(stderr, "%d ps particle migration (seconds) %f pre-barrier (seconds) %f\n",
-        comm_rank, timer.seconds(), btime);
-  Kokkos::Profiling::popRegion();
+  rebuild(new_element, recv_element, buffers.recv_particle);
 }
 
-template<class DataTypes, typename ExecSpace>
-bool SellCSigma<DataTypes,ExecSpace>::reshuffle(kkLidView new_element, 
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+bool SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::reshuffle(kkLidView new_element, 
                                                 kkLidView new_particle_elements, 
                                                 MemberTypeViews<DataTypes> new_particles) {
+  unshareLayout();
+  reserveColdEntries(new_particle_elements.size());
   //Count current/new particles per row
   kkLidView new_particles_per_row("new_particles_per_row", numRows());
   kkLidView num_holes_per_row("num_holes_per_row", numRows());
   kkLidView element_to_row_local = element_to_row;
   auto particle_mask_local = particle_mask;  
+  //Change in the particles of each element, applied once the reshuffle succeeds
+  kkLidView occupancy_change("occupancy_change", num_elems);
+  //Fails when particles are sent to an element without a row
+  kkLidView fail("fail",1);
   auto countNewParticles = SCS_LAMBDA(lid_t element_id,lid_t particle_id, bool mask){
     const lid_t new_elem = new_element(particle_id);
 
@@ -720,9 +1875,18 @@ bool SellCSigma<DataTypes,ExecSpace>::reshuffle(kkLidView new_element,
     const bool is_moving = is_particle & new_elem != element_id;
     if (is_moving) {
       const lid_t new_row = element_to_row_local(new_elem);
-      Kokkos::atomic_fetch_add(&(new_particles_per_row(new_row)), mask);
+      if (new_row < 0)
+        fail(0) = 1;
+      else {
+        Kokkos::atomic_fetch_add(&(new_particles_per_row(new_row)), mask);
+        Kokkos::atomic_fetch_add(&(occupancy_change(new_elem)), 1);
+        Kokkos::atomic_fetch_add(&(occupancy_change(element_id)), -1);
+      }
+    }
+    if (mask && !is_particle) {
+      particle_mask_local.clear(particle_id);
+      Kokkos::atomic_fetch_add(&(occupancy_change(element_id)), -1);
     }
-    particle_mask_local(particle_id) = is_particle;
     Kokkos::atomic_fetch_add(&(num_holes_per_row(row)), !is_particle);
   };
   parallel_for(countNewParticles, "countNewParticles");
@@ -730,20 +1894,31 @@ bool SellCSigma<DataTypes,ExecSpace>::reshuffle(kkLidView new_element,
   Kokkos::parallel_for("reshuffle_count", new_particle_elements.size(), KOKKOS_LAMBDA(const lid_t& i) {
       const lid_t new_elem = new_particle_elements(i);
       const lid_t new_row = element_to_row_local(new_elem);
-      Kokkos::atomic_fetch_add(&(new_particles_per_row(new_row)), 1);
+      if (new_row < 0)
+        fail(0) = 1;
+      else {
+        Kokkos::atomic_fetch_add(&(new_particles_per_row(new_row)), 1);
+        Kokkos::atomic_fetch_add(&(occupancy_change(new_elem)), 1);
+      }
     });
 
   //Check if the particles will fit in current structure
-  kkLidView fail("fail",1);
+  kkLidView overfull("overfull", 1);
   Kokkos::parallel_for(numRows(), KOKKOS_LAMBDA(const lid_t& i) {
       if( new_particles_per_row(i) > num_holes_per_row(i))
-        fail(0) = 1;
+        overfull(0) = 1;
   });
 
   if (getLastValue<lid_t>(fail)) {
     //Reshuffle fails
     return false;
   }
+  //Grow the chunks of the overfull rows or fall back to a full rebuild
+  if (getLastValue<lid_t>(overfull)) {
+    if (!localRegrowth || !regrowChunks(new_particles_per_row, num_holes_per_row))
+      return false;
+    particle_mask_local = particle_mask;
+  }
   
   //Offset moving particles
   kkLidView offset_new_particles("offset_new_particles", numRows() + 1);
@@ -756,20 +1931,20 @@ bool SellCSigma<DataTypes,ExecSpace>::reshuffle(kkLidView new_element,
     }
   });
 
-  int num_moving_ptcls = getLastValue<lid_t>(offset_new_particles);
+  lid_t num_moving_ptcls = getLastValue<lid_t>(offset_new_particles);
+  addOccupancyChange(occupancy_change);
   if (num_moving_ptcls == 0) {
-    Kokkos::parallel_reduce(capacity(), KOKKOS_LAMBDA(const lid_t& i, lid_t& sum) {
-      sum += particle_mask_local(i);
-    }, num_ptcls);
+    num_ptcls = particle_mask_local.count();
+    updateActiveSlots();
     return true;
   }
   kkLidView movingPtclIndices("movingPtclIndices", num_moving_ptcls);
   kkLidView isFromSCS("isFromSCS", num_moving_ptcls);
   //Gather moving particle list
+  //Slots appended by regrowChunks are empty and lie past the end of new_element
   auto gatherMovingPtcls = SCS_LAMBDA(const lid_t& element_id,const lid_t& particle_id, const bool& mask){
-    const lid_t new_elem = new_element(particle_id);
+    const lid_t new_elem = mask ? new_element(particle_id) : -1;
 
-    const lid_t row = element_to_row_local(element_id);
     const bool is_moving = new_elem != -1 & new_elem != element_id & mask;
     if (is_moving) {
       const lid_t new_row = element_to_row_local(new_elem);
@@ -809,25 +1984,291 @@ bool SellCSigma<DataTypes,ExecSpace>::reshuffle(kkLidView new_element,
       const lid_t new_index = holes(i);
       const lid_t fromSCS = isFromSCS(i);
       if (fromSCS == 1)
-        particle_mask_local(old_index) = 0;
-      particle_mask_local(new_index) = 1;
+        particle_mask_local.clear(old_index);
+      particle_mask_local.set(new_index);
   });
   
   //Shift SCS values
-  ShuffleParticles<kkLidView, DataTypes>(scs_data, new_particles, movingPtclIndices, holes,
-                                         isFromSCS);
+  unshareMembers(~cold_members);
+  ShuffleParticles<kkLidView, DataTypes>(scs_data, tileHeight(), new_particles,
+                                         movingPtclIndices, holes,
+                                         isFromSCS, ~cold_members);
+  //Move the cold index entries of the moving particles instead of the cold members
+  if (coldIndexed) {
+    kkLidView cold_index_local = cold_index;
+    kkLidView new_particle_slots("new_particle_slots", new_particle_elements.size());
+    Kokkos::parallel_for(num_moving_ptcls, KOKKOS_LAMBDA(const lid_t& i) {
+      const lid_t old_index = movingPtclIndices(i);
+      const lid_t new_index = holes(i);
+      if (isFromSCS(i) == 1)
+        cold_index_local(new_index) = cold_index_local(old_index);
+      else
+        new_particle_slots(old_index) = new_index;
+    });
+    addColdParticles(cold_index, new_particle_slots, new_particles);
+  }
 
   //Count number of active particles
-  Kokkos::parallel_reduce(capacity(), KOKKOS_LAMBDA(const lid_t& i, lid_t& sum) {
-      sum += particle_mask_local(i);
-  }, num_ptcls);
+  num_ptcls = particle_mask_local.count();
+  updateActiveSlots();
+  return true;
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::addOccupancyChange(
+                                                         kkLidView change) {
+  kkLidView particles_per_element_local = particles_per_element;
+  Kokkos::parallel_for("add_occupancy_change", num_elems, KOKKOS_LAMBDA(const lid_t& i) {
+    particles_per_element_local(i) += change(i);
+  });
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+bool SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::regrowChunks(
+                                                         kkLidView new_particles_per_row,
+                                                         kkLidView num_holes_per_row) {
+  //Appended slices would overlap the overflow region
+  if (num_overflow > 0)
+    return false;
+  //Width each chunk grows by to fit the particles entering its rows plus the row slack
+  const lid_t C_local = C_;
+  const lid_t V_local = V_;
+  const double row_slack = capacity_policy.row_slack;
+  const lid_t min_row_slack = capacity_policy.min_row_slack;
+  kkLidView chunk_growth("chunk_growth", num_chunks);
+  Kokkos::parallel_for("chunk_growth", numRows(), KOKKOS_LAMBDA(const lid_t& row) {
+    const lid_t deficit = new_particles_per_row(row) - num_holes_per_row(row);
+    if (deficit > 0) {
+      const lid_t growth = deficit + CapacityPolicy::slack(deficit, deficit, row_slack,
+                                                           min_row_slack);
+      Kokkos::atomic_fetch_max(&chunk_growth(row / C_local), growth);
+    }
+  });
+  kkLidView growth_slices("growth_slices", num_chunks + 1);
+  Kokkos::parallel_scan(num_chunks, KOKKOS_LAMBDA(const lid_t& i, lid_t& cur, const bool& final) {
+    cur += (chunk_growth(i) + V_local - 1) / V_local;
+    if (final)
+      growth_slices(i+1) = cur;
+  });
+  const lid_t num_new_slices = getLastValue<lid_t>(growth_slices);
+  if (num_new_slices == 0)
+    return false;
+
+  //Append the new slices of each chunk after the existing slices
+  const lid_t old_num_slices = num_slices;
+  const lid_t new_num_slices = num_slices + num_new_slices;
+  kkLidView new_offsets("SCS offset", new_num_slices + 1);
+  kkLidView new_slice_to_chunk("slice to chunk", new_num_slices);
+  kkLidView offsets_local = offsets;
+  kkLidView slice_to_chunk_local = slice_to_chunk;
+  Kokkos::parallel_for(num_slices + 1, KOKKOS_LAMBDA(const lid_t& i) {
+    new_offsets(i) = offsets_local(i);
+    if (i < old_num_slices)
+      new_slice_to_chunk(i) = slice_to_chunk_local(i);
+  });
+  kkLidView slice_size("slice_size", num_new_slices);
+  Kokkos::parallel_for(num_chunks, KOKKOS_LAMBDA(const lid_t& i) {
+    const lid_t growth = chunk_growth(i);
+    for (lid_t j = growth_slices(i); j < growth_slices(i+1); ++j) {
+      const lid_t width = growth - (j - growth_slices(i)) * V_local;
+      new_slice_to_chunk(old_num_slices + j) = i;
+      slice_size(j) = (width < V_local ? width : V_local) * C_local;
+    }
+  });
+  const lid_t old_capacity = capacity_;
+  Kokkos::parallel_scan(num_new_slices, KOKKOS_LAMBDA(const lid_t& i, lid_t& cur, const bool final) {
+    cur += slice_size(i);
+    if (final)
+      new_offsets(old_num_slices + i + 1) = old_capacity + cur;
+  });
+  const lid_t new_capacity = getLastValue<lid_t>(new_offsets);
+
+  //Copy the mask and, when their allocation is full, the members into larger views
+  //Existing particles keep their slots but every slot is copied
+  ParticleMask<ExecSpace, lid_t> new_particle_mask("particle_mask", new_capacity);
+  auto old_words = particle_mask.wordView();
+  auto new_words = new_particle_mask.wordView();
+  Kokkos::parallel_for("copy_mask", old_words.size(), KOKKOS_LAMBDA(const lid_t& i) {
+    new_words(i) = old_words(i);
+  });
+  if (static_cast<std::size_t>(new_capacity) > current_size) {
+    const std::size_t new_size = capacity_policy.reallocation(new_capacity, current_size);
+    RetileViewsInPlace<DataTypes>(scs_data, tileHeight(), tileHeight(), capacity_, new_size,
+                                  ~cold_members);
+    current_size = new_size;
+    //The hot members are new views that no snapshot shares
+    shared_members &= cold_members;
+  }
+  if (coldIndexed) {
+    kkLidView new_cold_index("cold_index", new_capacity);
+    kkLidView cold_index_local = cold_index;
+    Kokkos::parallel_for("copy_cold_index", capacity_, KOKKOS_LAMBDA(const lid_t& i) {
+      new_cold_index(i) = cold_index_local(i);
+    });
+    cold_index = new_cold_index;
+  }
+  //Every row of a grown chunk gains the width of its new slices
+  Kokkos::parallel_for(numRows(), KOKKOS_LAMBDA(const lid_t& row) {
+    num_holes_per_row(row) += chunk_growth(row / C_local);
+  });
+  num_slices = new_num_slices;
+  offsets = new_offsets;
+  slice_to_chunk = new_slice_to_chunk;
+  capacity_ = new_capacity;
+  particle_mask = new_particle_mask;
+  updateSlotElements();
   return true;
 }
 
-template<class DataTypes, typename ExecSpace>
-void SellCSigma<DataTypes,ExecSpace>::rebuild(kkLidView new_element, 
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::setColdMembers(unsigned int members,
+                                                                           int interval) {
+  static_assert(DataTypes::size <= 32, "cold members are selected by a 32 bit mask");
+  permuteColdMembers();
+  cold_members = members;
+  cold_interval = interval;
+  cold_rebuilds = 0;
+  cold_size = current_size;
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::permuteColdMembers() {
+  cold_rebuilds = 0;
+  if (!coldIndexed)
+    return;
+  GatherMembers<SellCSigma, DataTypes>(this, scs_data, tileHeight(), current_size, cold_tile,
+                                       cold_index, cold_members);
+  shared_members &= ~cold_members;
+  coldIndexed = false;
+  cold_index = kkLidView();
+  cold_used = 0;
+  cold_size = current_size;
+  //The cold views of the swap copy were never kept in step, recreate it at the next rebuild
+  destroyViews<DataTypes>(scs_data_swap);
+  swap_size = 0;
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::reserveColdEntries(lid_t num_new_ptcls) {
+  if (!cold_members)
+    return;
+  //Permuting drops the entries of the particles that left the structure, do so instead of
+  //  growing the cold members once most of their entries are unused
+  if (coldIndexed && cold_used + num_new_ptcls > static_cast<lid_t>(cold_size) &&
+      cold_used > 2 * num_ptcls)
+    permuteColdMembers();
+  if (!coldIndexed) {
+    cold_index = kkLidView("cold_index", capacity_);
+    kkLidView cold_index_local = cold_index;
+    Kokkos::parallel_for("identity_cold_index", capacity_, KOKKOS_LAMBDA(const lid_t& i) {
+      cold_index_local(i) = i;
+    });
+    cold_used = capacity_;
+    cold_tile = tileHeight();
+    coldIndexed = true;
+  }
+  if (cold_used + num_new_ptcls > static_cast<lid_t>(cold_size)) {
+    const std::size_t new_size =
+      wholeTiles(capacity_policy.allocation(cold_used + num_new_ptcls), cold_tile);
+    RetileViewsInPlace<DataTypes>(scs_data, cold_tile, cold_tile, cold_used, new_size,
+                                  cold_members);
+    cold_size = new_size;
+    shared_members &= ~cold_members;
+  }
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::addColdParticles(
+                                                 kkLidView index,
+                                                 kkLidView new_particle_slots,
+                                                 MemberTypeViews<DataTypes> new_particles) {
+  //New particles take the cold entries after the ones in use
+  const lid_t num_new_ptcls = new_particle_slots.size();
+  if (num_new_ptcls == 0)
+    return;
+  unshareMembers(cold_members);
+  kkLidView cold_entries("cold_entries", num_new_ptcls);
+  const lid_t start = cold_used;
+  Kokkos::parallel_for("add_cold_particles", num_new_ptcls, KOKKOS_LAMBDA(const lid_t& i) {
+    cold_entries(i) = start + i;
+    index(new_particle_slots(i)) = start + i;
+  });
+  CopyNewParticlesToSCS<SellCSigma, DataTypes>(this, scs_data, cold_tile, new_particles,
+                                               num_new_ptcls, cold_entries, cold_members);
+  cold_used += num_new_ptcls;
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::rebuild(kkLidView new_element, 
                                               kkLidView new_particle_elements, 
                                               MemberTypeViews<DataTypes> new_particles) {
+  rebuildWithKeys(new_element, new_particle_elements, new_particles, kkLidView());
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+template <typename KeyFunction>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::rebuild(kkLidView new_element,
+                                              KeyFunction& sort_key,
+                                              kkLidView new_particle_elements,
+                                              MemberTypeViews<DataTypes> new_particles) {
+  kkLidView ptcl_keys("ptcl_keys", capacity());
+  auto setKeys = SCS_LAMBDA(const lid_t& element_id, const lid_t& particle_id,
+                            const bool& mask) {
+    if (mask && new_element(particle_id) != -1)
+      ptcl_keys(particle_id) = sort_key(particle_id);
+  };
+  parallel_for(setKeys, "set_sort_keys");
+  rebuildWithKeys(new_element, new_particle_elements, new_particles, ptcl_keys);
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+typename SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::kkLidView
+SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::rankParticles(kkLidView new_element,
+                                                                         kkLidView ptcl_keys,
+                                                                         kkLidView elem_fill) {
+  //Group the moving particles by new element
+  auto countMoving = SCS_LAMBDA(const lid_t& element_id, const lid_t& particle_id,
+                                const bool& mask) {
+    const lid_t new_elem = new_element(particle_id);
+    if (mask && new_elem != -1)
+      Kokkos::atomic_fetch_add(&elem_fill(new_elem), 1);
+  };
+  parallel_for(countMoving, "count_moving");
+  kkLidView fill_offsets("fill_offsets", num_elems + 1);
+  Kokkos::parallel_scan("fill_offsets", num_elems,
+                        KOKKOS_LAMBDA(const lid_t& i, lid_t& cur, const bool& final) {
+    cur += elem_fill(i);
+    if (final)
+      fill_offsets(i+1) = cur;
+  });
+  kkLidView ids("moving_ids", getLastValue<lid_t>(fill_offsets));
+  kkLidView elem_cursor("elem_cursor", num_elems);
+  auto groupMoving = SCS_LAMBDA(const lid_t& element_id, const lid_t& particle_id,
+                                const bool& mask) {
+    const lid_t new_elem = new_element(particle_id);
+    if (mask && new_elem != -1)
+      ids(fill_offsets(new_elem) + Kokkos::atomic_fetch_add(&elem_cursor(new_elem), 1)) =
+        particle_id;
+  };
+  parallel_for(groupMoving, "group_moving");
+
+  //Sort the particles of each element by key and rank them within the element
+  kkLidView ranks("particle_ranks", capacity());
+  Kokkos::parallel_for("particle_ranks", num_elems, KOKKOS_LAMBDA(const lid_t& elem) {
+    const lid_t begin = fill_offsets(elem);
+    const lid_t end = fill_offsets(elem + 1);
+    heapSortIds(ids, ptcl_keys, begin, end);
+    for (lid_t i = begin; i < end; ++i)
+      ranks(ids(i)) = i - begin;
+  });
+  return ranks;
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::rebuildWithKeys(kkLidView new_element,
+                                              kkLidView new_particle_elements,
+                                              MemberTypeViews<DataTypes> new_particles,
+                                              kkLidView ptcl_keys) {
   const auto btime = prebarrier();
   Kokkos::Profiling::pushRegion("scs_rebuild");
   Kokkos::Timer timer;
@@ -836,43 +2277,71 @@ void SellCSigma<DataTypes,ExecSpace>::rebuild(kkLidView new_element,
   MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
 
   //If tryShuffling is on and shuffling works then rebuild is complete
-  if (tryShuffling && reshuffle(new_element, new_particle_elements, new_particles)) {
+  const bool sorted = ptcl_keys.size() > 0;
+  if (tryShuffling && !sorted && reshuffle(new_element, new_particle_elements, new_particles)) {
+    countColdRebuild();
     Kokkos::Profiling::popRegion();
     return;
   }
-  kkLidView new_particles_per_elem("new_particles_per_elem", numRows());
+  reserveColdEntries(new_particle_elements.size());
+  kkLidView new_particles_per_elem("new_particles_per_elem", numElementIds());
+  //Particles arriving in each element to size the row slack
+  kkLidView inflow_per_elem("inflow_per_elem", numElementIds());
   auto countNewParticles = SCS_LAMBDA(lid_t element_id,lid_t particle_id, bool mask){
     const lid_t new_elem = new_element(particle_id);
-    if (new_elem != -1)
+    if (new_elem != -1) {
       Kokkos::atomic_fetch_add(&(new_particles_per_elem(new_elem)), mask);
+      if (new_elem != element_id)
+        Kokkos::atomic_fetch_add(&(inflow_per_elem(new_elem)), mask);
+    }
   };
   parallel_for(countNewParticles, "countNewParticles");
   // Add new particles to counts
   Kokkos::parallel_for("rebuild_count", new_particle_elements.size(), KOKKOS_LAMBDA(const lid_t& i) {
     const lid_t new_elem = new_particle_elements(i);
     Kokkos::atomic_fetch_add(&(new_particles_per_elem(new_elem)), 1);
+    Kokkos::atomic_fetch_add(&(inflow_per_elem(new_elem)), 1);
   });
   lid_t activePtcls;
-  Kokkos::parallel_reduce(numRows(), KOKKOS_LAMBDA(const lid_t& i, lid_t& sum) {
+  Kokkos::parallel_reduce(numElementIds(), KOKKOS_LAMBDA(const lid_t& i, lid_t& sum) {
     sum+= new_particles_per_elem(i);
   }, activePtcls);
   //If there are no particles left, then destroy the structure
   if(activePtcls == 0) {
     num_ptcls = 0;
     num_slices = 0;
+    num_overflow = 0;
     capacity_ = 0;
+    particles_per_element = kkLidView("particles_per_element", num_elems);
+    updateSlotElements();
+    updateActiveSlots();
     return;
   }
   lid_t new_num_ptcls = activePtcls;
 
-  int new_C = chooseChunkHeight<ExecSpace>(C_max, new_particles_per_elem);
-  int old_C = C_;
-  C_ = new_C;
+  //Reserve empty slots in each row so later steps can reshuffle into them
+  //  and cap the rows so heavy elements spill into the overflow region
+  kkLidView row_sizes = new_particles_per_elem;
+  if (capacity_policy.hasSlack() || capacity_policy.hasOverflow()) {
+    row_sizes = kkLidView("row_sizes", new_particles_per_elem.size());
+    const double row_slack = capacity_policy.row_slack;
+    const lid_t min_row_slack = capacity_policy.min_row_slack;
+    const lid_t max_width = capacity_policy.max_row_width;
+    Kokkos::parallel_for("reserve_slack", row_sizes.size(), KOKKOS_LAMBDA(const lid_t& i) {
+      const lid_t count = new_particles_per_elem(i);
+      row_sizes(i) = capRowSize(count + CapacityPolicy::slack(count, inflow_per_elem(i),
+                                                              row_slack, min_row_slack),
+                                max_width);
+    });
+  }
   //Perform sorting
   Kokkos::Profiling::pushRegion("Sorting");
   PairView<ExecSpace> ptcls;
-  sigmaSort<ExecSpace>(ptcls,num_elems,new_particles_per_elem, sigma);
+  lid_t new_C;
+  sortRows(row_sizes, ptcls, new_C);
   Kokkos::Profiling::popRegion();
+  int old_C = C_;
+  C_ = new_C;
 
   // Number of chunks without vertical slicing
   kkLidView chunk_widths;
@@ -880,6 +2349,11 @@ void SellCSigma<DataTypes,ExecSpace>::rebuild(kkLidView new_element,
   kkLidView new_row_to_element;
   kkLidView new_element_to_row;
   constructChunks(ptcls, new_nchunks, chunk_widths, new_row_to_element, new_element_to_row);
+  kkLidView new_element_row_offsets;
+  kkLidView new_element_rows;
+  kkLidView row_widths;
+  constructElementRows(ptcls, new_nchunks * new_C, new_element_row_offsets, new_element_rows,
+                       row_widths);
 
   lid_t new_num_slices;
   lid_t new_capacity;
@@ -889,13 +2363,23 @@ void SellCSigma<DataTypes,ExecSpace>::rebuild(kkLidView new_element,
   constructOffsets(new_nchunks, new_num_slices, chunk_widths, new_offsets, new_slice_to_chunk,
                    new_capacity);
 
-  //Allocate the SCS
-  lid_t new_cap = getLastValue<lid_t>(new_offsets);
-  kkLidView new_particle_mask("new_particle_mask", new_cap);
-  if (swap_size < new_cap) {
+  //Place the particles beyond the capped row sizes after the chunks
+  lid_t new_num_overflow;
+  kkLidView new_overflow_offsets;
+  kkLidView new_overflow_to_element;
+  constructOverflow(new_particles_per_elem, row_sizes, new_num_overflow, new_overflow_offsets,
+                    new_overflow_to_element);
+  const lid_t new_overflow_start = new_capacity;
+  new_capacity += new_num_overflow;
+
+  //Allocate the SCS with the overflow region padded to a full tile of C slots
+  lid_t new_cap = new_overflow_start + (new_num_overflow + new_C - 1) / new_C * new_C;
+  ParticleMask<ExecSpace, lid_t> new_particle_mask("new_particle_mask", new_capacity);
+  const std::size_t new_swap_size = capacity_policy.reallocation(new_cap, swap_size);
+  if (!inPlaceRebuild && (!scs_data_swap.isAllocated() || new_swap_size != swap_size)) {
     destroyViews<DataTypes>(scs_data_swap);
-    CreateViews<DataTypes>(scs_data_swap, new_cap*1.1);
-    swap_size = new_cap * 1.1;
+    scs_data_swap = createMemberViews<DataTypes>(new_swap_size);
+    swap_size = new_swap_size;
   }
 
   
@@ -917,107 +2401,201 @@ void SellCSigma<DataTypes,ExecSpace>::rebuild(kkLidView new_element,
       }
   });
   C_ = old_C;
+  //Particles fill the rows and then the overflow slots of their element in the order of
+  //  their keys when they are sorted
+  kkLidView elem_fill("elem_fill", num_elems);
+  kkLidView ptcl_ranks;
+  if (sorted)
+    ptcl_ranks = rankParticles(new_element, ptcl_keys, elem_fill);
   kkLidView new_indices("new_scs_index", capacity());
   auto copySCS = SCS_LAMBDA(lid_t elm_id, lid_t ptcl_id, bool mask) {
     const lid_t new_elem = new_element(ptcl_id);
     //TODO remove conditional
     if (mask && new_elem != -1) {
-      const lid_t new_row = new_element_to_row(new_elem);
-      new_indices(ptcl_id) = Kokkos::atomic_fetch_add(&element_index(new_row), new_C);
+      const lid_t k = sorted ? ptcl_ranks(ptcl_id) :
+        Kokkos::atomic_fetch_add(&elem_fill(new_elem), 1);
+      new_indices(ptcl_id) = elementSlot(k, new_elem, new_element_row_offsets, new_element_rows,
+                                         row_widths, element_index, new_C,
+                                         new_overflow_start + new_overflow_offsets(new_elem));
       const lid_t new_index = new_indices(ptcl_id);
-      new_particle_mask(new_index) = 1;
+      new_particle_mask.set(new_index);
     }
   };
   parallel_for(copySCS);
 
-  CopySCSToSCS<SellCSigma<DataTypes, ExecSpace>, DataTypes>(this, scs_data_swap, scs_data,
-                                                            new_element, new_indices);
+  //Members are written to the swap views or staged back into scs_data when in place
+  MemberTypeViews<DataTypes> new_data = scs_data_swap;
+  if (inPlaceRebuild) {
+    const std::size_t new_size = capacity_policy.reallocation(new_cap, current_size);
+    StageSCSToSCS<SellCSigma, DataTypes>(this, scs_data,
+                                         tileMembers * new_C, new_size,
+                                         new_element, new_indices, ~cold_members);
+    current_size = new_size;
+    new_data = scs_data;
+    shared_members &= cold_members;
+  }
+  else
+    CopySCSToSCS<SellCSigma, DataTypes>(this, scs_data_swap,
+                                        tileMembers * new_C, scs_data,
+                                        new_element, new_indices, ~cold_members);
   //Add new particles
   lid_t num_new_ptcls = new_particle_elements.size(); 
   kkLidView new_particle_indices("new_particle_scs_indices", num_new_ptcls);
 
   Kokkos::parallel_for("set_new_particle", num_new_ptcls, KOKKOS_LAMBDA(const lid_t& i) {
     lid_t new_elem = new_particle_elements(i);
-    lid_t new_row = new_element_to_row(new_elem);
-    new_particle_indices(i) = Kokkos::atomic_fetch_add(&element_index(new_row), new_C);
+    const lid_t k = Kokkos::atomic_fetch_add(&elem_fill(new_elem), 1);
+    new_particle_indices(i) = elementSlot(k, new_elem, new_element_row_offsets,
+                                          new_element_rows, row_widths, element_index, new_C,
+                                          new_overflow_start + new_overflow_offsets(new_elem));
     lid_t new_index = new_particle_indices(i);
-    new_particle_mask(new_index) = 1;
+    new_particle_mask.set(new_index);
   });
   
   if (new_particle_elements.size() > 0)
-    CopyNewParticlesToSCS<SellCSigma<DataTypes, ExecSpace>, DataTypes>(this, scs_data_swap,
-                                                                       new_particles,
-                                                                       num_new_ptcls,
-                                                                       new_particle_indices);
+    CopyNewParticlesToSCS<SellCSigma, DataTypes>(this, new_data,
+                                                 tileMembers * new_C,
+                                                 new_particles,
+                                                 num_new_ptcls,
+                                                 new_particle_indices,
+                                                 ~cold_members);
+
+  //The cold members stay in place and their index entries follow the particles
+  if (coldIndexed) {
+    kkLidView new_cold_index("cold_index", new_capacity);
+    kkLidView cold_index_local = cold_index;
+    auto moveColdIndex = SCS_LAMBDA(lid_t elm_id, lid_t ptcl_id, bool mask) {
+      if (mask && new_element(ptcl_id) != -1)
+        new_cold_index(new_indices(ptcl_id)) = cold_index_local(ptcl_id);
+    };
+    parallel_for(moveColdIndex);
+    addColdParticles(new_cold_index, new_particle_indices, new_particles);
+    cold_index = new_cold_index;
+  }
+
+  //Reorder the element arrays from the entries of the old rows to the new rows
+  const bool new_rowless = capacity_policy.skip_empty;
+  if (!element_arrays.empty()) {
+    kkLidView src_entries = elementEntrySources(new_row_to_element, new_nchunks * new_C,
+                                                new_rowless);
+    kkLidView element_to_row_local = element_to_row;
+    const lid_t old_rows = numRows();
+    Kokkos::parallel_for("element_array_sources", src_entries.size(),
+                         KOKKOS_LAMBDA(const lid_t& i) {
+      const lid_t elem = src_entries(i);
+      if (elem >= 0) {
+        const lid_t row = element_to_row_local(elem);
+        src_entries(i) = row >= 0 ? row : old_rows + elem;
+      }
+    });
+    for (std::size_t i = 0; i < element_arrays.size(); ++i)
+      element_arrays[i]->permute(src_entries);
+  }
+  rowlessElements = new_rowless;
 
   //set scs to point to new values
+  kkLidView particles_per_element_local("particles_per_element", num_elems);
+  Kokkos::parallel_for("set_particles_per_element", num_elems, KOKKOS_LAMBDA(const lid_t& i) {
+    particles_per_element_local(i) = new_particles_per_elem(i);
+  });
+  particles_per_element = particles_per_element_local;
   C_ = new_C;
   num_ptcls = new_num_ptcls;
   num_chunks = new_nchunks;
   num_slices = new_num_slices;
   capacity_ = new_capacity;
+  num_overflow = new_num_overflow;
+  overflow_offsets = new_overflow_offsets;
+  overflow_to_element = new_overflow_to_element;
   row_to_element = new_row_to_element;
   element_to_row = new_element_to_row;
+  element_row_offsets = new_element_row_offsets;
+  element_rows = new_element_rows;
+  num_element_ids = num_elems + numRows() - ptcls.size();
   offsets = new_offsets;
   slice_to_chunk = new_slice_to_chunk;
   particle_mask = new_particle_mask;
-  MemberTypeViews<DataTypes> tmp = scs_data;
-  scs_data = scs_data_swap;
-  scs_data_swap = tmp;
-  std::size_t tmp_size = current_size;
-  current_size = swap_size;
-  swap_size = tmp_size;
+  if (!inPlaceRebuild) {
+    MemberTypeViews<DataTypes> tmp = scs_data;
+    scs_data = scs_data_swap;
+    scs_data_swap = tmp;
+    std::size_t tmp_size = current_size;
+    current_size = swap_size;
+    swap_size = tmp_size;
+    //The cold members were not copied to the swap views
+    swapMemberViews(scs_data, scs_data_swap, cold_members);
+    releaseSharedSwap(~cold_members);
+  }
+  updateSlotElements();
+  updateActiveSlots();
+  countColdRebuild();
   if(!comm_rank || comm_rank == comm_size/2)
     fprintf(stderr, "%d ps rebuild (seconds) %f pre-barrier (seconds) %f\n",
         comm_rank, timer.seconds(), btime);
   Kokkos::Profiling::popRegion();
 }
 
-template<class DataTypes, typename ExecSpace>
-void SellCSigma<DataTypes,ExecSpace>::printFormat(const char* prefix) const {
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::printFormat(const char* prefix) const {
   //Transfer everything to the host
   kkLidHostMirror slice_to_chunk_host = deviceToHost(slice_to_chunk);
   kkGidHostMirror element_to_gid_host = deviceToHost(element_to_gid);
   kkLidHostMirror row_to_element_host = deviceToHost(row_to_element);
   kkLidHostMirror offsets_host = deviceToHost(offsets);
-  kkLidHostMirror particle_mask_host = deviceToHost(particle_mask);
+  auto particle_mask_host = particle_mask.toHost();
   char message[10000];
   char* cur = message;
   cur += sprintf(cur, "%s\n", prefix);
-  cur += sprintf(cur,"Particle Structures Sell-C-Sigma C: %d sigma: %d V: %d.\n", C_, sigma, V_);
-  cur += sprintf(cur,"Number of Elements: %d.\nNumber of Particles: %d.\n", num_elems, num_ptcls);
-  cur += sprintf(cur,"Number of Chunks: %d.\nNumber of Slices: %d.\n", num_chunks, num_slices);
+  cur += sprintf(cur,"Particle Structures Sell-C-Sigma C: %ld sigma: %ld V: %ld.\n", (long)C_,
+                 (long)sigma, (long)V_);
+  cur += sprintf(cur,"Number of Elements: %ld.\nNumber of Particles: %ld.\n", (long)num_elems,
+                 (long)num_ptcls);
+  cur += sprintf(cur,"Number of Chunks: %ld.\nNumber of Slices: %ld.\n", (long)num_chunks,
+                 (long)num_slices);
   lid_t last_chunk = -1;
   for (lid_t i = 0; i < num_slices; ++i) {
     lid_t chunk = slice_to_chunk_host(i);
     if (chunk != last_chunk) {
       last_chunk = chunk;
-      cur += sprintf(cur,"  Chunk %d. Elements", chunk);
+      cur += sprintf(cur,"  Chunk %ld. Elements", (long)chunk);
       if (element_to_gid_host.size() > 0)
         cur += sprintf(cur,"(GID)");
       cur += sprintf(cur,":");
       for (lid_t row = chunk*C_; row < (chunk+1)*C_; ++row) {
         lid_t elem = row_to_element_host(row);
-        cur += sprintf(cur," %d", elem);
+        cur += sprintf(cur," %ld", (long)elem);
+        //Padded rows may be past the ids shared by another structure
         if (element_to_gid_host.size() > 0) {
-          cur += sprintf(cur,"(%ld)", element_to_gid_host(elem));
+          const long gid = static_cast<std::size_t>(elem) < element_to_gid_host.size() ?
+            element_to_gid_host(elem) : -1;
+          cur += sprintf(cur,"(%ld)", gid);
         }
       }
       cur += sprintf(cur,"\n");
     }
-    cur += sprintf(cur,"    Slice %d", i);
+    cur += sprintf(cur,"    Slice %ld", (long)i);
     for (lid_t j = offsets_host(i); j < offsets_host(i+1); ++j) {
       if ((j - offsets_host(i)) % C_ == 0)
         cur += sprintf(cur," |");
-      cur += sprintf(cur," %d", particle_mask_host(j));
+      cur += sprintf(cur," %d", ParticleMask<ExecSpace, lid_t>::test(particle_mask_host, j));
     }
     cur += sprintf(cur,"\n");
   }
+  if (num_overflow > 0) {
+    kkLidHostMirror overflow_to_element_host = deviceToHost(overflow_to_element);
+    const lid_t overflow_start = capacity_ - num_overflow;
+    cur += sprintf(cur,"  Overflow Slots(Element):");
+    for (lid_t j = 0; j < num_overflow; ++j)
+      cur += sprintf(cur," %d(%ld)", ParticleMask<ExecSpace, lid_t>::test(particle_mask_host,
+                                                                         overflow_start + j),
+                     (long)overflow_to_element_host(j));
+    cur += sprintf(cur,"\n");
+  }
   printf("%s", message);
 }
 
-template <class DataTypes, typename ExecSpace>
-void SellCSigma<DataTypes, ExecSpace>::printMetrics() const {
+template <class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::printMetrics() const {
 
   //Gather metrics
   kkLidView padded_cells("padded_cells", 1);
@@ -1033,14 +2611,15 @@ void SellCSigma<DataTypes, ExecSpace>::printMetrics() const {
   Kokkos::parallel_for("GatherMetrics", policy, KOKKOS_LAMBDA(const team_policy::member_type& thread) {
     const lid_t slice = thread.league_rank();
     const lid_t slice_row = thread.team_rank();
-    const lid_t rowLen = (offsets_cpy(slice+1)-offsets_cpy(slice))/team_size;
+    const lid_t C = chunkHeight(team_size);
+    const lid_t rowLen = (offsets_cpy(slice+1)-offsets_cpy(slice))/C;
     const lid_t start = offsets_cpy(slice) + slice_row;
-    const lid_t row = slice_to_chunk_cpy(slice) * team_size + slice_row;
+    const lid_t row = slice_to_chunk_cpy(slice) * C + slice_row;
     const lid_t element_id = row_to_element_cpy(row);
     lid_t np = 0;
     for (lid_t p = 0; p < rowLen; ++p) {
-      const lid_t particle_id = start+(p*team_size);
-      const lid_t mask = particle_mask_cpy[particle_id];
+      const lid_t particle_id = start+(p*C);
+      const lid_t mask = particle_mask_cpy(particle_id);
       np += !mask;
     }
     Kokkos::atomic_fetch_add(&padded_cells[0],np);
@@ -1058,26 +2637,32 @@ void SellCSigma<DataTypes, ExecSpace>::printMetrics() const {
   char* ptr = buffer;
   
   //Header
-  ptr += sprintf(ptr, "Metrics %d, C %d, V %d, sigma %d\n", comm_rank, C_, V_, sigma);
+  ptr += sprintf(ptr, "Metrics %d, C %ld, V %ld, sigma %ld\n", comm_rank, (long)C_, (long)V_,
+                 (long)sigma);
   //Sizes
-  ptr += sprintf(ptr, "Nelems %d, Nchunks %d, Nslices %d, Nptcls %d, Capacity %d, Allocation %d\n",
-                 nElems(), num_chunks, num_slices, nPtcls(), capacity(), current_size + swap_size);
+  ptr += sprintf(ptr, "Nelems %ld, Nchunks %ld, Nslices %ld, Nptcls %ld, Capacity %ld, "
+                 "Allocation %zu\n", (long)nElems(), (long)num_chunks, (long)num_slices,
+                 (long)nPtcls(), (long)capacity(), current_size + swap_size);
   //Padded Cells
-  ptr += sprintf(ptr, "Padded Cells <Tot %> %d %.3f\n", num_padded,
-                 num_padded * 100.0 / particle_mask.size());
+  ptr += sprintf(ptr, "Padded Cells <Tot %> %ld %.3f\n", (long)num_padded,
+                 num_padded * 100.0 / (capacity_ - num_overflow));
+  //Overflow Slots
+  ptr += sprintf(ptr, "Overflow Slots <Tot %%> %ld %.3f\n", (long)num_overflow,
+                 num_overflow * 100.0 / capacity_);
   //Padded Slices
-  ptr += sprintf(ptr, "Padded Slices <Tot %> %d %.3f\n", num_padded_slices,
+  ptr += sprintf(ptr, "Padded Slices <Tot %> %ld %.3f\n", (long)num_padded_slices,
                  num_padded_slices * 100.0 / num_slices);
   //Empty Elements
-  ptr += sprintf(ptr, "Empty Rows <Tot %> %d %.3f\n", num_empty_elements,
+  ptr += sprintf(ptr, "Empty Rows <Tot %> %ld %.3f\n", (long)num_empty_elements,
                  num_empty_elements * 100.0 / numRows());
 
   printf("%s\n",buffer);
 }
   
-template <class DataTypes, typename ExecSpace>
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
 template <typename FunctionType>
-void SellCSigma<DataTypes, ExecSpace>::parallel_for(FunctionType& fn, std::string name) {
+FunctionType* SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::deviceFunction(
+                                                                        FunctionType& fn) {
   FunctionType* fn_d;
 #ifdef SCS_USE_CUDA
   cudaMalloc(&fn_d, sizeof(FunctionType));
@@ -1085,6 +2670,23 @@ void SellCSigma<DataTypes, ExecSpace>::parallel_for(FunctionType& fn, std::strin
 #else
   fn_d = &fn;
 #endif
+  return fn_d;
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+template <typename FunctionType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::freeDeviceFunction(
+                                                                        FunctionType* fn_d) {
+#ifdef SCS_USE_CUDA
+  //cudaFree waits for the kernels using the copy to finish
+  cudaFree(fn_d);
+#endif
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+template <typename RowFunction>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::parallel_for_slots(RowFunction fn,
+                                                                               std::string name) {
   const lid_t league_size = num_slices;
   const lid_t team_size = C_;
   typedef Kokkos::TeamPolicy<Kokkos::DefaultExecutionSpace> team_policy;
@@ -1096,18 +2698,99 @@ void SellCSigma<DataTypes, ExecSpace>::parallel_for(FunctionType& fn, std::strin
   Kokkos::parallel_for(name, policy, KOKKOS_LAMBDA(const team_policy::member_type& thread) {
     const lid_t slice = thread.league_rank();
     const lid_t slice_row = thread.team_rank();
-    const lid_t rowLen = (offsets_cpy(slice+1)-offsets_cpy(slice))/team_size;
+    const lid_t C = chunkHeight(team_size);
+    const lid_t rowLen = (offsets_cpy(slice+1)-offsets_cpy(slice))/C;
     const lid_t start = offsets_cpy(slice) + slice_row;
-    Kokkos::parallel_for(Kokkos::TeamThreadRange(thread, team_size), [=] (lid_t& j) {
-      const lid_t row = slice_to_chunk_cpy(slice) * team_size + slice_row;
+    Kokkos::parallel_for(Kokkos::TeamThreadRange(thread, C), [=] (lid_t& j) {
+      const lid_t row = slice_to_chunk_cpy(slice) * C + slice_row;
       const lid_t element_id = row_to_element_cpy(row);
       Kokkos::parallel_for(Kokkos::ThreadVectorRange(thread, rowLen), [&] (lid_t& p) {
-        const lid_t particle_id = start+(p*team_size);
-        const lid_t mask = particle_mask_cpy[particle_id];
-        (*fn_d)(element_id, particle_id, mask);
+        const lid_t particle_id = start+(p*C);
+        const lid_t mask = particle_mask_cpy(particle_id);
+        fn(element_id, row, particle_id, mask);
       });
     });
   });
+  //Visit the overflow slots of heavy elements, they use one of the rows of their element
+  if (num_overflow > 0) {
+    auto overflow_to_element_cpy = overflow_to_element;
+    auto element_to_row_cpy = element_to_row;
+    const lid_t overflow_start = capacity_ - num_overflow;
+    Kokkos::parallel_for(name, num_overflow, KOKKOS_LAMBDA(const lid_t& i) {
+      const lid_t particle_id = overflow_start + i;
+      const lid_t mask = particle_mask_cpy(particle_id);
+      const lid_t element_id = overflow_to_element_cpy(i);
+      fn(element_id, element_to_row_cpy(element_id), particle_id, mask);
+    });
+  }
+}
+
+template <class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+template <typename FunctionType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::parallel_for(FunctionType& fn, std::string name) {
+  FunctionType* fn_d = deviceFunction(fn);
+  auto slotFunction = SCS_LAMBDA(const lid_t& element_id, const lid_t& row,
+                                 const lid_t& particle_id, const lid_t& mask) {
+    (*fn_d)(element_id, particle_id, mask);
+  };
+  parallel_for_slots(slotFunction, name);
+  freeDeviceFunction(fn_d);
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+template <typename FunctionType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::parallel_for_flat(FunctionType& fn,
+                                                                              std::string name) {
+  if (!slotElements) {
+    parallel_for(fn, name);
+    return;
+  }
+  FunctionType* fn_d = deviceFunction(fn);
+  auto slot_to_element_cpy = slot_to_element;
+  auto particle_mask_cpy = particle_mask;
+  Kokkos::parallel_for(name, Kokkos::RangePolicy<ExecSpace>(0, capacity_),
+                       KOKKOS_LAMBDA(const lid_t& particle_id) {
+    const lid_t mask = particle_mask_cpy(particle_id);
+    (*fn_d)(slot_to_element_cpy(particle_id), particle_id, mask);
+  });
+  freeDeviceFunction(fn_d);
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+template <typename FunctionType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::parallel_for_active(FunctionType& fn,
+                                                                                std::string name) {
+  if (!activeSlots) {
+    auto activeOnly = SCS_LAMBDA(const lid_t& element_id, const lid_t& particle_id,
+                                 const bool& mask) {
+      if (mask)
+        fn(element_id, particle_id, mask);
+    };
+    parallel_for(activeOnly, name);
+    return;
+  }
+  FunctionType* fn_d = deviceFunction(fn);
+  auto active_slots_cpy = active_slots;
+  auto active_elements_cpy = active_elements;
+  Kokkos::parallel_for(name, Kokkos::RangePolicy<ExecSpace>(0, active_slots.size()),
+                       KOKKOS_LAMBDA(const lid_t& i) {
+    const lid_t mask = 1;
+    (*fn_d)(active_elements_cpy(i), active_slots_cpy(i), mask);
+  });
+  freeDeviceFunction(fn_d);
+}
+
+template<class DataTypes, typename ExecSpace, lid_t FixedC, lid_t FixedV, typename LidType>
+template <typename FunctionType>
+void SellCSigma<DataTypes, ExecSpace, FixedC, FixedV, LidType>::parallel_for_rows(FunctionType& fn,
+                                                                              std::string name) {
+  FunctionType* fn_d = deviceFunction(fn);
+  auto slotFunction = SCS_LAMBDA(const lid_t& element_id, const lid_t& row,
+                                 const lid_t& particle_id, const lid_t& mask) {
+    (*fn_d)(element_id, row, particle_id, mask);
+  };
+  parallel_for_slots(slotFunction, name);
+  freeDeviceFunction(fn_d);
 }
 
 } // end namespace particle_structs
@@ -0,0 +1,209 @@
+#pragma once
+
+#include "SellCSigma.h"
+
+namespace particle_structs {
+
+/* A batch of many small SellCSigma structures stored in one structure
+   The elements of the instances are numbered one instance after the other, so every
+   instance shares the allocations of the batch and parallel_for, reshuffle and rebuild
+   launch their kernels once for the whole batch instead of once per instance. Particles
+   stay in their instance, elements are given to and returned from the batch as the
+   instance (batch) and the element within the instance.
+*/
+template<class DataTypes, typename ExecSpace = Kokkos::DefaultExecutionSpace>
+class SellCSigmaBatch {
+ public:
+  typedef SellCSigma<DataTypes, ExecSpace> SCS;
+  typedef typename SCS::lid_t lid_t;
+  typedef typename SCS::PolicyType PolicyType;
+  typedef typename SCS::kkLidView kkLidView;
+  typedef typename SCS::kkConstLidView kkConstLidView;
+
+  SellCSigmaBatch() = delete;
+  SellCSigmaBatch(const SellCSigmaBatch&) = delete;
+  SellCSigmaBatch& operator=(const SellCSigmaBatch&) = delete;
+  /* Constructor of a batch of structures
+    p - a Kokkos::TeamPolicy that defines the value of C based on the device
+    sigma - the sorting parameter shared by the instances
+    vertical_chunk_size - tuning parameter for load balancing of irregular row lengths
+    batch_elements - the number of elements of each instance
+    num_particles - the number of particles of all instances
+    particles_per_element - the number of particles in each element of each instance,
+                            the elements of the first instance followed by the second...
+    particle_batches - instance of each particle (optional)
+    particle_elements - parent element within its instance for each particle (optional)
+    particle_info - Initial values for the particle information (optional)
+    cap_policy - over allocation, shrinking and row slack of the batch (optional)
+  */
+  SellCSigmaBatch(PolicyType& p, lid_t sigma, lid_t vertical_chunk_size,
+                  kkLidView batch_elements, lid_t num_particles,
+                  kkLidView particles_per_element,
+                  kkLidView particle_batches = kkLidView(),
+                  kkLidView particle_elements = kkLidView(),
+                  MemberTypeViews<DataTypes> particle_info = MemberTypeViews<DataTypes>(),
+                  CapacityPolicy cap_policy = CapacityPolicy());
+  ~SellCSigmaBatch() {delete scs;}
+
+  //Returns the number of instances in the batch
+  lid_t nBatches() const {return num_batches;}
+  //Returns the number of elements of all instances
+  lid_t nElems() const {return scs->nElems();}
+  //Returns the number of particles of all instances
+  lid_t nPtcls() const {return scs->nPtcls();}
+  //Returns the capacity of the batch including padding
+  lid_t capacity() const {return scs->capacity();}
+  //Returns the offset of the elements of each instance in the batch (size nBatches() + 1)
+  kkConstLidView elementOffsets() const {return element_offsets;}
+  //Returns the number of particles in each element of the batch
+  kkConstLidView particlesPerElement() const {return scs->particlesPerElement();}
+  //Returns the structure storing the batch for its settings
+  SCS* structure() {return scs;}
+
+  //Gets the Nth datatype of the batch to be indexed by particle id
+  template <std::size_t N>
+  Segment<typename MemberTypeAtIndex<N,DataTypes>::type, ExecSpace, lid_t> get() {
+    return scs->template get<N>();
+  }
+
+  /*
+    Moves the particles of every instance to new elements of their instance
+    new_element - array sized capacity() with the new element within the instance of each
+                  particle (-1 removes the particle)
+      Optional arguments when adding new particles to the batch
+      new_particle_batches - the instance of each new particle
+      new_particle_elements - the new element within its instance of each new particle
+      new_particles - the data for the new particles
+    reshuffle returns false when the particles do not fit in the current layout
+  */
+  bool reshuffle(kkLidView new_element, kkLidView new_particle_batches = kkLidView(),
+                 kkLidView new_particle_elements = kkLidView(),
+                 MemberTypeViews<DataTypes> new_particles = MemberTypeViews<DataTypes>());
+  void rebuild(kkLidView new_element, kkLidView new_particle_batches = kkLidView(),
+               kkLidView new_particle_elements = kkLidView(),
+               MemberTypeViews<DataTypes> new_particles = MemberTypeViews<DataTypes>());
+
+  /*
+    Performs a parallel for over the elements/particles of every instance
+    The passed in functor/lambda should take in 4 arguments (lid_t batch, lid_t elm_id,
+    lid_t ptcl_id, bool mask) where elm_id is the element within the instance batch.
+    The padded rows of the batch are not visited.
+  */
+  template <typename FunctionType>
+  void parallel_for(FunctionType& fn, std::string s="");
+
+ private:
+  //Converts elements within the instances of batches to elements of the batch
+  kkLidView batchElements(kkLidView batches, kkLidView elements);
+  //Converts the new elements within the instances of the particles to elements of the batch
+  kkLidView batchNewElements(kkLidView new_element);
+
+  lid_t num_batches;
+  //CSR offsets of the elements of each instance
+  kkLidView element_offsets;
+  //instance of each element of the batch
+  kkLidView element_to_batch;
+  //Structure storing the elements of every instance
+  SCS* scs;
+};
+
+template<class DataTypes, typename ExecSpace>
+SellCSigmaBatch<DataTypes, ExecSpace>::SellCSigmaBatch(PolicyType& p, lid_t sigma, lid_t v,
+                                                       kkLidView batch_elements, lid_t np,
+                                                       kkLidView ptcls_per_elem,
+                                                       kkLidView particle_batches,
+                                                       kkLidView particle_elements,
+                                                       MemberTypeViews<DataTypes> particle_info,
+                                                       CapacityPolicy cap_policy) {
+  num_batches = batch_elements.size();
+  element_offsets = kkLidView("element_offsets", num_batches + 1);
+  kkLidView element_offsets_local = element_offsets;
+  Kokkos::parallel_scan("batch_offsets", num_batches,
+                        KOKKOS_LAMBDA(const lid_t& i, lid_t& cur, const bool& final) {
+    cur += batch_elements(i);
+    if (final)
+      element_offsets_local(i+1) = cur;
+  });
+  const lid_t ne = getLastValue<lid_t>(element_offsets);
+  element_to_batch = kkLidView("element_to_batch", ne);
+  kkLidView element_to_batch_local = element_to_batch;
+  Kokkos::parallel_for("set_element_to_batch", num_batches, KOKKOS_LAMBDA(const lid_t& i) {
+    for (lid_t e = element_offsets_local(i); e < element_offsets_local(i+1); ++e)
+      element_to_batch_local(e) = i;
+  });
+
+  kkLidView elements = particle_elements;
+  if (particle_elements.size() > 0)
+    elements = batchElements(particle_batches, particle_elements);
+  typename SCS::kkGidView element_gids("element_gids", 0);
+  scs = new SCS(p, sigma, v, ne, np, ptcls_per_elem, element_gids, elements, particle_info,
+                cap_policy);
+}
+
+template<class DataTypes, typename ExecSpace>
+typename SellCSigmaBatch<DataTypes, ExecSpace>::kkLidView
+SellCSigmaBatch<DataTypes, ExecSpace>::batchElements(kkLidView batches, kkLidView elements) {
+  kkLidView batch_elements("batch_elements", elements.size());
+  kkLidView element_offsets_local = element_offsets;
+  Kokkos::parallel_for("batch_elements", elements.size(), KOKKOS_LAMBDA(const lid_t& i) {
+    batch_elements(i) = element_offsets_local(batches(i)) + elements(i);
+  });
+  return batch_elements;
+}
+
+template<class DataTypes, typename ExecSpace>
+typename SellCSigmaBatch<DataTypes, ExecSpace>::kkLidView
+SellCSigmaBatch<DataTypes, ExecSpace>::batchNewElements(kkLidView new_element) {
+  kkLidView batch_new_element("batch_new_element", scs->capacity());
+  kkLidView element_offsets_local = element_offsets;
+  kkLidView element_to_batch_local = element_to_batch;
+  const lid_t ne = scs->nElems();
+  auto convertElements = SCS_LAMBDA(const lid_t& element_id, const lid_t& particle_id,
+                                    const bool& mask) {
+    lid_t elem = -1;
+    if (mask && element_id < ne && new_element(particle_id) != -1)
+      elem = element_offsets_local(element_to_batch_local(element_id)) +
+        new_element(particle_id);
+    batch_new_element(particle_id) = elem;
+  };
+  scs->parallel_for(convertElements, "batch_new_elements");
+  return batch_new_element;
+}
+
+template<class DataTypes, typename ExecSpace>
+bool SellCSigmaBatch<DataTypes, ExecSpace>::reshuffle(kkLidView new_element,
+                                                      kkLidView new_particle_batches,
+                                                      kkLidView new_particle_elements,
+                                                      MemberTypeViews<DataTypes> new_particles) {
+  return scs->reshuffle(batchNewElements(new_element),
+                        batchElements(new_particle_batches, new_particle_elements),
+                        new_particles);
+}
+
+template<class DataTypes, typename ExecSpace>
+void SellCSigmaBatch<DataTypes, ExecSpace>::rebuild(kkLidView new_element,
+                                                    kkLidView new_particle_batches,
+                                                    kkLidView new_particle_elements,
+                                                    MemberTypeViews<DataTypes> new_particles) {
+  scs->rebuild(batchNewElements(new_element),
+               batchElements(new_particle_batches, new_particle_elements),
+               new_particles);
+}
+
+template<class DataTypes, typename ExecSpace>
+template <typename FunctionType>
+void SellCSigmaBatch<DataTypes, ExecSpace>::parallel_for(FunctionType& fn, std::string name) {
+  kkLidView element_offsets_local = element_offsets;
+  kkLidView element_to_batch_local = element_to_batch;
+  const lid_t ne = scs->nElems();
+  auto batchFn = SCS_LAMBDA(const lid_t& element_id, const lid_t& particle_id,
+                            const bool& mask) {
+    if (element_id < ne) {
+      const lid_t batch = element_to_batch_local(element_id);
+      fn(batch, element_id - element_offsets_local(batch), particle_id, mask);
+    }
+  };
+  scs->parallel_for(batchFn, name);
+}
+
+}
@@ -0,0 +1,222 @@
+#pragma once
+
+#include "SellCSigma.h"
+
+namespace particle_structs {
+
+/* A species of particles in a group, hides the member types of its structure
+   Each call runs one phase of the migration of the species (see SellCSigma::migrate)
+*/
+template <typename LidView>
+class SpeciesBase {
+ public:
+  typedef Kokkos::View<char*, typename LidView::device_type> ByteView;
+  virtual ~SpeciesBase() {}
+  virtual void rebuild(LidView new_element) = 0;
+  virtual void countMigration(LidView new_process, LidView num_send, int nspecies,
+                              int species) = 0;
+  virtual void packMigration(LidView new_element, LidView new_process, LidView num_send,
+                             LidView num_recv, int nspecies, int species) = 0;
+  //Bytes of a particle of the species in the messages
+  virtual std::size_t migrationEntryBytes() const = 0;
+  virtual void packMessages(ByteView send_bytes, const std::vector<std::size_t>& send_starts) = 0;
+  virtual void unpackMessages(ByteView recv_bytes,
+                              const std::vector<std::size_t>& recv_starts) = 0;
+  virtual void finishMigration(LidView new_element, LidView new_process) = 0;
+  //Releases the sent and received particles
+  virtual void clearMigration() = 0;
+};
+
+template <class SCS>
+class Species : public SpeciesBase<typename SCS::kkLidView> {
+ public:
+  typedef typename SCS::kkLidView kkLidView;
+  typedef typename SpeciesBase<kkLidView>::ByteView ByteView;
+  Species(SCS* s) : scs(s) {}
+
+  void rebuild(kkLidView new_element) {scs->rebuild(new_element);}
+  void countMigration(kkLidView new_process, kkLidView num_send, int nspecies, int species) {
+    scs->countMigration(new_process, num_send, nspecies, species);
+  }
+  void packMigration(kkLidView new_element, kkLidView new_process, kkLidView num_send,
+                     kkLidView num_recv, int nspecies, int species) {
+    scs->packMigration(new_element, new_process, num_send, num_recv, nspecies, species,
+                       buffers);
+  }
+  std::size_t migrationEntryBytes() const {return SCS::migrationEntryBytes();}
+  void packMessages(ByteView send_bytes, const std::vector<std::size_t>& send_starts) {
+    scs->packMessages(buffers, send_bytes, send_starts);
+  }
+  void unpackMessages(ByteView recv_bytes, const std::vector<std::size_t>& recv_starts) {
+    scs->unpackMessages(buffers, recv_bytes, recv_starts);
+  }
+  void finishMigration(kkLidView new_element, kkLidView new_process) {
+    scs->finishMigration(new_element, new_process, buffers);
+  }
+  void clearMigration() {buffers = typename SCS::MigrationBuffers();}
+
+  SCS* scs;
+  typename SCS::MigrationBuffers buffers;
+};
+
+/* Structures of several species of particles on the same mesh
+   The structures share the global ids of the elements of the first species added and
+   migrate together: the particle counts of every species are exchanged with a single
+   Alltoall and the particles of every species sent to a process travel in one message,
+   so the number of messages of a migration does not grow with the number of species.
+*/
+template <typename ExecSpace = Kokkos::DefaultExecutionSpace, typename LidType = lid_t>
+class SpeciesGroup {
+ public:
+  typedef LidType lid_t;
+  typedef Kokkos::View<lid_t*, typename ExecSpace::device_type> kkLidView;
+  typedef Kokkos::View<gid_t*, typename ExecSpace::device_type> kkGidView;
+  typedef Kokkos::UnorderedMap<gid_t, lid_t, typename ExecSpace::device_type> GID_Mapping;
+  typedef Kokkos::View<char*, typename ExecSpace::device_type> ByteView;
+
+  SpeciesGroup() {}
+  SpeciesGroup(const SpeciesGroup&) = delete;
+  SpeciesGroup& operator=(const SpeciesGroup&) = delete;
+  ~SpeciesGroup() {
+    for (std::size_t i = 0; i < species.size(); ++i)
+      delete species[i];
+  }
+
+  /* Adds the structure of a species to the group, the group does not take ownership
+     The structures added after the first one use its element ids so they must have the
+     same elements and element ids.
+     Returns the index of the species in the group
+  */
+  template <class SCS>
+  int addSpecies(SCS* scs);
+  //Returns the number of species in the group
+  int nSpecies() const {return species.size();}
+
+  /* Migrates the particles of every species in one communication round
+     new_elements[s] - array sized capacity() of species s with the new element of each
+                       particle
+     new_processes[s] - array sized capacity() of species s with the new process of each
+                        particle
+  */
+  void migrate(std::vector<kkLidView> new_elements, std::vector<kkLidView> new_processes);
+
+ private:
+  std::vector<SpeciesBase<kkLidView>*> species;
+  //Element ids shared by the species
+  kkGidView element_to_gid;
+  GID_Mapping element_gid_to_lid;
+  lid_t num_elems, num_element_ids;
+};
+
+template <typename ExecSpace, typename LidType>
+template <class SCS>
+int SpeciesGroup<ExecSpace, LidType>::addSpecies(SCS* scs) {
+  if (species.empty()) {
+    element_to_gid = scs->elementToGid();
+    element_gid_to_lid = scs->elementGidToLid();
+    num_elems = scs->nElems();
+    num_element_ids = scs->numElementIds();
+  }
+  else {
+    PS_ALWAYS_ASSERT(scs->nElems() == num_elems);
+    PS_ALWAYS_ASSERT(scs->numElementIds() == num_element_ids);
+    scs->shareElementIds(element_to_gid, element_gid_to_lid);
+  }
+  species.push_back(new Species<SCS>(scs));
+  return species.size() - 1;
+}
+
+template <typename ExecSpace, typename LidType>
+void SpeciesGroup<ExecSpace, LidType>::migrate(std::vector<kkLidView> new_elements,
+                                               std::vector<kkLidView> new_processes) {
+  const auto btime = prebarrier();
+  Kokkos::Profiling::pushRegion("species_migrate");
+  Kokkos::Timer timer;
+  const int nspecies = species.size();
+  PS_ALWAYS_ASSERT(new_elements.size() == species.size());
+  PS_ALWAYS_ASSERT(new_processes.size() == species.size());
+  int comm_size;
+  MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
+  int comm_rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
+
+  if (comm_size == 1) {
+    for (int s = 0; s < nspecies; ++s)
+      species[s]->rebuild(new_elements[s]);
+    Kokkos::Profiling::popRegion();
+    return;
+  }
+  /********* Send # of particles of each species being sent to each process *********/
+  kkLidView num_send_particles("num_send_particles", comm_size * nspecies);
+  for (int s = 0; s < nspecies; ++s)
+    species[s]->countMigration(new_processes[s], num_send_particles, nspecies, s);
+  kkLidView num_recv_particles("num_recv_particles", comm_size * nspecies);
+  PS_Comm_Alltoall(num_send_particles, nspecies, num_recv_particles, nspecies,
+                   MPI_COMM_WORLD);
+
+  lid_t num_moving = 0;
+  Kokkos::parallel_reduce("sum_moving", comm_size * nspecies,
+                          KOKKOS_LAMBDA(const lid_t& i, lid_t& lsum) {
+    lsum += num_send_particles(i) + num_recv_particles(i);
+  }, num_moving);
+  if (num_moving == 0) {
+    for (int s = 0; s < nspecies; ++s)
+      species[s]->rebuild(new_elements[s]);
+    Kokkos::Profiling::popRegion();
+    return;
+  }
+
+  /********** Send the particles of every species to their new processes **********/
+  for (int s = 0; s < nspecies; ++s)
+    species[s]->packMigration(new_elements[s], new_processes[s], num_send_particles,
+                              num_recv_particles, nspecies, s);
+  //The message to or from each process holds the particles of each species in turn
+  auto num_send_host = deviceToHost(num_send_particles);
+  auto num_recv_host = deviceToHost(num_recv_particles);
+  std::vector<std::size_t> send_offsets(comm_size + 1, 0), recv_offsets(comm_size + 1, 0);
+  std::vector<std::vector<std::size_t> > send_starts(nspecies), recv_starts(nspecies);
+  for (int s = 0; s < nspecies; ++s) {
+    send_starts[s].resize(comm_size);
+    recv_starts[s].resize(comm_size);
+  }
+  for (int i = 0; i < comm_size; ++i) {
+    send_offsets[i + 1] = send_offsets[i];
+    recv_offsets[i + 1] = recv_offsets[i];
+    for (int s = 0; s < nspecies; ++s) {
+      const std::size_t entry_bytes = species[s]->migrationEntryBytes();
+      send_starts[s][i] = send_offsets[i + 1];
+      recv_starts[s][i] = recv_offsets[i + 1];
+      send_offsets[i + 1] += num_send_host(i * nspecies + s) * entry_bytes;
+      recv_offsets[i + 1] += num_recv_host(i * nspecies + s) * entry_bytes;
+    }
+  }
+  ByteView send_bytes("send_bytes", send_offsets[comm_size]);
+  ByteView recv_bytes("recv_bytes", recv_offsets[comm_size]);
+  for (int s = 0; s < nspecies; ++s)
+    species[s]->packMessages(send_bytes, send_starts[s]);
+  MPI_Request* send_requests = new MPI_Request[comm_size];
+  MPI_Request* recv_requests = new MPI_Request[comm_size];
+  int num_sends, num_recvs;
+  PS_Comm_Messages(send_bytes, send_offsets, recv_bytes, recv_offsets, 0, MPI_COMM_WORLD,
+                   send_requests, num_sends, recv_requests, num_recvs);
+  PS_Comm_Waitall<ExecSpace>(num_recvs, recv_requests, MPI_STATUSES_IGNORE);
+  delete [] recv_requests;
+  for (int s = 0; s < nspecies; ++s)
+    species[s]->unpackMessages(recv_bytes, recv_starts[s]);
+
+  /********** Combine and shift particles to their new destination **********/
+  for (int s = 0; s < nspecies; ++s)
+    species[s]->finishMigration(new_elements[s], new_processes[s]);
+
+  //Cleanup
+  PS_Comm_Waitall<ExecSpace>(num_sends, send_requests, MPI_STATUSES_IGNORE);
+  delete [] send_requests;
+  for (int s = 0; s < nspecies; ++s)
+    species[s]->clearMigration();
+  if(!comm_rank || comm_rank == comm_size/2)
+    fprintf(stderr, "%d ps species migration (seconds) %f pre-barrier (seconds) %f\n",
+        comm_rank, timer.seconds(), btime);
+  Kokkos::Profiling::popRegion();
+}
+
+}
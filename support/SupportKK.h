@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Kokkos_Core.hpp>
+#include "MemberTypes.h"
 
 namespace particle_structs {
 
@@ -20,7 +21,7 @@ template <class T, typename ExecSpace>
 
 template <typename T, typename ExecSpace>
 T getLastValue(Kokkos::View<T*, ExecSpace> view) {
-  const int size = view.size();
+  const std::size_t size = view.size();
   if (size == 0)
     return 0;
   T lastVal;
@@ -29,22 +30,27 @@ T getLastValue(Kokkos::View<T*, ExecSpace> view) {
 }
 
 template <class T, typename ExecSpace> struct CopyViewToView {
-  KOKKOS_INLINE_FUNCTION CopyViewToView(Kokkos::View<T*, ExecSpace> dst, int dst_index,
-                                              Kokkos::View<T*, ExecSpace> src, int src_index) {
+  KOKKOS_INLINE_FUNCTION CopyViewToView(Kokkos::View<T*, ExecSpace> dst, std::size_t dst_index,
+                                              Kokkos::View<T*, ExecSpace> src,
+                                              std::size_t src_index) {
     dst(dst_index) = src(src_index);
   }
 };
 template <class T, typename ExecSpace, int N> struct CopyViewToView<T[N], ExecSpace> {
-  KOKKOS_INLINE_FUNCTION CopyViewToView(Kokkos::View<T*[N], ExecSpace> dst, int dst_index,
-                                              Kokkos::View<T*[N], ExecSpace> src, int src_index) {
+  KOKKOS_INLINE_FUNCTION CopyViewToView(Kokkos::View<T*[N], ExecSpace> dst,
+                                              std::size_t dst_index,
+                                              Kokkos::View<T*[N], ExecSpace> src,
+                                              std::size_t src_index) {
     for (int i = 0; i < N; ++i)
       dst(dst_index, i) = src(src_index, i);
   }
 };
 template <class T, typename ExecSpace, int N, int M> 
 struct CopyViewToView<T[N][M], ExecSpace> {
-  KOKKOS_INLINE_FUNCTION CopyViewToView(Kokkos::View<T*[N][M], ExecSpace> dst, int dst_index,
-                                              Kokkos::View<T*[N][M], ExecSpace> src, int src_index) {
+  KOKKOS_INLINE_FUNCTION CopyViewToView(Kokkos::View<T*[N][M], ExecSpace> dst,
+                                              std::size_t dst_index,
+                                              Kokkos::View<T*[N][M], ExecSpace> src,
+                                              std::size_t src_index) {
     for (int i = 0; i < N; ++i)
       for (int j = 0; j < M; ++j)
         src(src_index, i, j) = dst(dst_index, i, j);
@@ -53,9 +59,9 @@ struct CopyViewToView<T[N][M], ExecSpace> {
 template <class T, typename ExecSpace, int N, int M, int P> 
   struct CopyViewToView<T[N][M][P], ExecSpace> {
   KOKKOS_INLINE_FUNCTION CopyViewToView(Kokkos::View<T*[N][M][P], ExecSpace> dst, 
-                                              int dst_index,
+                                              std::size_t dst_index,
                                               Kokkos::View<T*[N][M][P], ExecSpace> src, 
-                                              int src_index) {
+                                              std::size_t src_index) {
     for (int i = 0; i < N; ++i)
       for (int j = 0; j < M; ++j)
         for (int k = 0; k < P; ++k)
@@ -63,9 +69,70 @@ template <class T, typename ExecSpace, int N, int M, int P>
   }
 };
 
+//Index of component comp of entry index when entries are stored in tiles of tile entries
+//  with each component of the tile contiguous (array of structs of arrays)
+template <typename Lid>
+KOKKOS_INLINE_FUNCTION Lid tiledIndex(Lid index, int comp, int ncomps, int tile) {
+  const Lid tile_id = index / tile;
+  const Lid lane = index - tile_id * tile;
+  return (tile_id * ncomps + comp) * tile + lane;
+}
+
+/* Access to the comp-th flattened component of entry index of a member view
+   tile - 0 uses the native layout of the view, otherwise entries are stored in tiles
+          of tile entries component by component
+*/
+template <class T, typename ExecSpace> struct MemberEntry {
+  template <typename Lid>
+  KOKKOS_INLINE_FUNCTION static T& get(Kokkos::View<T*, ExecSpace> view, Lid index,
+                                       int, int) {
+    return view(index);
+  }
+};
+template <class T, typename ExecSpace, int N> struct MemberEntry<T[N], ExecSpace> {
+  template <typename Lid>
+  KOKKOS_INLINE_FUNCTION static T& get(Kokkos::View<T*[N], ExecSpace> view, Lid index,
+                                       int comp, int tile) {
+    if (tile)
+      return view.data()[tiledIndex(index, comp, N, tile)];
+    return view(index, comp);
+  }
+};
+template <class T, typename ExecSpace, int N, int M> struct MemberEntry<T[N][M], ExecSpace> {
+  template <typename Lid>
+  KOKKOS_INLINE_FUNCTION static T& get(Kokkos::View<T*[N][M], ExecSpace> view, Lid index,
+                                       int comp, int tile) {
+    if (tile)
+      return view.data()[tiledIndex(index, comp, N * M, tile)];
+    return view(index, comp / M, comp % M);
+  }
+};
+template <class T, typename ExecSpace, int N, int M, int P>
+struct MemberEntry<T[N][M][P], ExecSpace> {
+  template <typename Lid>
+  KOKKOS_INLINE_FUNCTION static T& get(Kokkos::View<T*[N][M][P], ExecSpace> view, Lid index,
+                                       int comp, int tile) {
+    if (tile)
+      return view.data()[tiledIndex(index, comp, N * M * P, tile)];
+    return view(index, comp / (M * P), (comp / P) % M, comp % P);
+  }
+};
+
+//Copy an entry between member views that may use different tile heights (0 = native layout)
+template <class T, typename ExecSpace> struct CopyTiledEntry {
+  template <class View, typename DstLid, typename SrcLid>
+  KOKKOS_INLINE_FUNCTION CopyTiledEntry(View dst, DstLid dst_index, int dst_tile,
+                                        View src, SrcLid src_index, int src_tile) {
+    constexpr int ncomps = BaseType<T>::size;
+    for (int c = 0; c < ncomps; ++c)
+      MemberEntry<T, ExecSpace>::get(dst, dst_index, c, dst_tile) =
+        MemberEntry<T, ExecSpace>::get(src, src_index, c, src_tile);
+  }
+};
+
   template <typename T> struct Subview {
     template <typename View>
-    static View subview(View view, int start, int size) {
+    static View subview(View view, std::size_t start, int size) {
       View new_view("subview", size);
       Kokkos::parallel_for(size, KOKKOS_LAMBDA(const int& i) {
         new_view(i) = view(start + i);
@@ -75,7 +142,7 @@ template <class T, typename ExecSpace, int N, int M, int P>
   };
   template <typename T, size_t N> struct Subview<T[N]> {
     template <typename View>
-    static View subview(View view, int start, int size) {
+    static View subview(View view, std::size_t start, int size) {
       View new_view("subview", size);
       Kokkos::parallel_for(size, KOKKOS_LAMBDA(const int& i) {
         for (int j = 0; j < N; ++j)
@@ -87,7 +154,7 @@ template <class T, typename ExecSpace, int N, int M, int P>
   template <typename T, size_t N, size_t M>
   struct Subview<T[N][M]> {
     template <typename View>
-    static View subview(View view, int start, int size) {
+    static View subview(View view, std::size_t start, int size) {
       View new_view("subview", size);
       Kokkos::parallel_for(size, KOKKOS_LAMBDA(const int& i) {
         for (int j = 0; j < N; ++j)
@@ -100,7 +167,7 @@ template <class T, typename ExecSpace, int N, int M, int P>
   template <typename T, size_t N, size_t M, size_t P>
   struct Subview<T[N][M][P]> {
     template <typename View>
-    static View subview(View view, int start, int size) {
+    static View subview(View view, std::size_t start, int size) {
       View new_view("subview", size);
       Kokkos::parallel_for(size, KOKKOS_LAMBDA(const int& i) {
         for (int j = 0; j < N; ++j)
@@ -3,7 +3,10 @@
 #include <Kokkos_Core.hpp>
 #include "SupportKK.h"
 #include "MemberTypes.h"
+#include "psAssert.h"
 #include <unordered_map>
+#include <vector>
+#include <climits>
 #include <mpi.h>
 namespace particle_structs {
   template <typename T> struct MpiType;
@@ -45,34 +48,34 @@ namespace particle_structs {
     typename std::enable_if<std::is_same<typename ExecSpace::memory_space, Kokkos::HostSpace>::value, int>::type;
   //Send
   template <typename T, typename ExecSpace>
-  IsHost<ExecSpace> PS_Comm_Send(Kokkos::View<T*, ExecSpace> view, int offset, int size,
+  IsHost<ExecSpace> PS_Comm_Send(Kokkos::View<T*, ExecSpace> view, std::size_t offset, int size,
                                  int dest, int tag, MPI_Comm comm) {
     int size_per_entry = BaseType<T>::size;
-    return MPI_Send(view.data() + offset, size*size_per_entry, MpiType<BT<T> >::mpitype(), 
+    return MPI_Send(view.data() + offset * size_per_entry, size*size_per_entry, MpiType<BT<T> >::mpitype(), 
                     dest, tag, comm);
   }
   //Recv
   template <typename T, typename ExecSpace>
-  IsHost<ExecSpace> PS_Comm_Recv(Kokkos::View<T*, ExecSpace> view, int offset, int size,
+  IsHost<ExecSpace> PS_Comm_Recv(Kokkos::View<T*, ExecSpace> view, std::size_t offset, int size,
                                  int sender, int tag, MPI_Comm comm) {
     int size_per_entry = BaseType<T>::size;
-    return MPI_Recv(view.data() + offset, size*size_per_entry, MpiType<BT<T> >::mpitype(), 
+    return MPI_Recv(view.data() + offset * size_per_entry, size*size_per_entry, MpiType<BT<T> >::mpitype(), 
                     sender, tag, comm, MPI_STATUS_IGNORE);
   }
   //Isend
   template <typename T, typename ExecSpace>
-  IsHost<ExecSpace> PS_Comm_Isend(Kokkos::View<T*, ExecSpace> view, int offset, int size,
+  IsHost<ExecSpace> PS_Comm_Isend(Kokkos::View<T*, ExecSpace> view, std::size_t offset, int size,
                                             int dest, int tag, MPI_Comm comm, MPI_Request* req) {
     int size_per_entry = BaseType<T>::size;
-    return MPI_Isend(view.data() + offset, size*size_per_entry, MpiType<BT<T> >::mpitype(), 
+    return MPI_Isend(view.data() + offset * size_per_entry, size*size_per_entry, MpiType<BT<T> >::mpitype(), 
                      dest, tag, comm, req);
   }
   //Irecv
   template <typename T, typename ExecSpace>
-  IsHost<ExecSpace> PS_Comm_Irecv(Kokkos::View<T*, ExecSpace> view, int offset, int size,
+  IsHost<ExecSpace> PS_Comm_Irecv(Kokkos::View<T*, ExecSpace> view, std::size_t offset, int size,
                                             int sender, int tag, MPI_Comm comm, MPI_Request* req) {
     int size_per_entry = BaseType<T>::size;
-    return MPI_Irecv(view.data() + offset, size*size_per_entry, MpiType<BT<T> >::mpitype(), 
+    return MPI_Irecv(view.data() + offset * size_per_entry, size*size_per_entry, MpiType<BT<T> >::mpitype(), 
                      sender, tag, comm, req);
   }
   //Waitall
@@ -103,7 +106,7 @@ namespace particle_structs {
 
   //Send
   template <typename T, typename ExecSpace>
-  IsCuda<ExecSpace> PS_Comm_Send(Kokkos::View<T*, ExecSpace> view, int offset, int size,
+  IsCuda<ExecSpace> PS_Comm_Send(Kokkos::View<T*, ExecSpace> view, std::size_t offset, int size,
                                  int dest, int tag, MPI_Comm comm) {
     auto subview = Subview<T>::subview(view, offset, size);
 
@@ -118,7 +121,7 @@ namespace particle_structs {
   }
   //Recv
   template <typename T, typename ExecSpace>
-  IsCuda<ExecSpace> PS_Comm_Recv(Kokkos::View<T*, ExecSpace> view, int offset, int size,
+  IsCuda<ExecSpace> PS_Comm_Recv(Kokkos::View<T*, ExecSpace> view, std::size_t offset, int size,
                                  int sender, int tag, MPI_Comm comm) {
     Kokkos::View<T*, ExecSpace> new_view("recv_view", size);
 #ifdef PS_CUDA_AWARE_MPI
@@ -140,7 +143,7 @@ namespace particle_structs {
 
   //Isend
   template <typename T, typename ExecSpace>
-  IsCuda<ExecSpace> PS_Comm_Isend(Kokkos::View<T*, ExecSpace> view, int offset, int size,
+  IsCuda<ExecSpace> PS_Comm_Isend(Kokkos::View<T*, ExecSpace> view, std::size_t offset, int size,
                                   int dest, int tag, MPI_Comm comm, MPI_Request* req) {
     auto subview = Subview<T>::subview(view, offset, size);
 #ifdef PS_CUDA_AWARE_MPI
@@ -159,7 +162,7 @@ namespace particle_structs {
   }
   //Irecv
   template <typename T, typename ExecSpace>
-  IsCuda<ExecSpace> PS_Comm_Irecv(Kokkos::View<T*, ExecSpace> view, int offset, int size,
+  IsCuda<ExecSpace> PS_Comm_Irecv(Kokkos::View<T*, ExecSpace> view, std::size_t offset, int size,
                                   int sender, int tag, MPI_Comm comm, MPI_Request* req) {
     int size_per_entry = BaseType<T>::size;
     Kokkos::View<T*, ExecSpace> new_view("irecv_view", size);
@@ -224,6 +227,34 @@ namespace particle_structs {
 
 #endif
 
-
+  /* Posts one message to and one message from each process
+     The bytes send_offsets[i] to send_offsets[i+1] of send_bytes are sent to process i and
+     the bytes recv_offsets[i] to recv_offsets[i+1] of recv_bytes are received from it.
+     Empty messages are not posted, the number of requests posted is returned in num_sends
+     and num_recvs. The request arrays need room for a request per process.
+     MPI counts are ints so each message must hold at most INT_MAX bytes.
+  */
+  template <typename ExecSpace>
+  void PS_Comm_Messages(Kokkos::View<char*, ExecSpace> send_bytes,
+                        const std::vector<std::size_t>& send_offsets,
+                        Kokkos::View<char*, ExecSpace> recv_bytes,
+                        const std::vector<std::size_t>& recv_offsets, int tag, MPI_Comm comm,
+                        MPI_Request* send_requests, int& num_sends,
+                        MPI_Request* recv_requests, int& num_recvs) {
+    num_sends = num_recvs = 0;
+    const int nprocs = send_offsets.size() - 1;
+    for (int i = 0; i < nprocs; ++i) {
+      const std::size_t send_size = send_offsets[i+1] - send_offsets[i];
+      PS_ALWAYS_ASSERT(send_size <= static_cast<std::size_t>(INT_MAX));
+      if (send_size > 0)
+        PS_Comm_Isend(send_bytes, send_offsets[i], send_size, i, tag, comm,
+                      send_requests + num_sends++);
+      const std::size_t recv_size = recv_offsets[i+1] - recv_offsets[i];
+      PS_ALWAYS_ASSERT(recv_size <= static_cast<std::size_t>(INT_MAX));
+      if (recv_size > 0)
+        PS_Comm_Irecv(recv_bytes, recv_offsets[i], recv_size, i, tag, comm,
+                      recv_requests + num_recvs++);
+    }
+  }
 
 }
@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <Kokkos_Core.hpp>
+
+#include <MemberTypes.h>
+#include <SellCSigmaBatch.h>
+#include <SCS_Macros.h>
+
+#include <psAssert.h>
+#include <Distribute.h>
+
+using particle_structs::SellCSigmaBatch;
+using particle_structs::MemberTypes;
+using particle_structs::getLastValue;
+using particle_structs::lid_t;
+using particle_structs::distribute_particles;
+
+typedef MemberTypes<int> Type;
+typedef Kokkos::DefaultExecutionSpace exe_space;
+typedef SellCSigmaBatch<Type, exe_space> Batch;
+
+//Every particle stores 100 * instance + element
+int checkValues(Batch* batch, lid_t& count) {
+  auto values = batch->get<0>();
+  Batch::kkLidView fail("fail", 1);
+  Batch::kkLidView num("num", 1);
+  auto checkParticle = SCS_LAMBDA(const int& b, const int& element_id, const int& particle_id,
+                                  const bool mask) {
+    if (mask) {
+      Kokkos::atomic_fetch_add(&num(0), 1);
+      if (values(particle_id) != 100 * b + element_id) {
+        printf("[ERROR] Particle %d of element %d in instance %d has value %d\n",
+               particle_id, element_id, b, values(particle_id));
+        fail(0) = 1;
+      }
+    }
+  };
+  batch->parallel_for(checkParticle);
+  count = getLastValue<lid_t>(num);
+  return getLastValue<lid_t>(fail);
+}
+
+int main(int argc, char* argv[]) {
+  MPI_Init(&argc, &argv);
+  Kokkos::initialize(argc, argv);
+  bool passed = true;
+  {
+    //Many small instances of 5 elements and 20 particles
+    const int nb = 50;
+    const int ne = 5;
+    const int np = 20;
+    int* ptcls_per_elem = new int[ne];
+    std::vector<int>* ids = new std::vector<int>[ne];
+    distribute_particles(ne, np, 0, ptcls_per_elem, ids);
+    Batch::kkLidView batch_elements("batch_elements", nb);
+    Kokkos::deep_copy(batch_elements, ne);
+    Batch::kkLidView instance_ptcls("instance_ptcls", ne);
+    particle_structs::hostToDevice(instance_ptcls, ptcls_per_elem);
+    Batch::kkLidView ptcls_per_elem_v("ptcls_per_elem_v", nb * ne);
+    Kokkos::parallel_for(nb * ne, KOKKOS_LAMBDA(const int& i) {
+      ptcls_per_elem_v(i) = instance_ptcls(i % ne);
+    });
+    delete [] ptcls_per_elem;
+    delete [] ids;
+
+    Kokkos::TeamPolicy<exe_space> po(128, 4);
+    Batch* batch = new Batch(po, 5, 2, batch_elements, nb * np, ptcls_per_elem_v);
+    if (batch->nBatches() != nb || batch->nElems() != nb * ne || batch->nPtcls() != nb * np) {
+      printf("[ERROR] Batch has %d instances, %d elements and %d particles\n",
+             batch->nBatches(), batch->nElems(), batch->nPtcls());
+      passed = false;
+    }
+    auto values = batch->get<0>();
+    auto setValues = SCS_LAMBDA(const int& b, const int& element_id, const int& particle_id,
+                                const bool mask) {
+      values(particle_id) = 100 * b + element_id;
+    };
+    batch->parallel_for(setValues);
+    lid_t count;
+    int fail = checkValues(batch, count);
+
+    //Move every particle to the next element of its instance and add one particle to the
+    //  first element of every instance
+    Batch::kkLidView new_element("new_element", batch->capacity());
+    auto moveParticles = SCS_LAMBDA(const int& b, const int& element_id,
+                                    const int& particle_id, const bool mask) {
+      new_element(particle_id) = (element_id + 1) % ne;
+      values(particle_id) = 100 * b + (element_id + 1) % ne;
+    };
+    batch->parallel_for(moveParticles);
+    Batch::kkLidView new_particle_batches("new_particle_batches", nb);
+    Batch::kkLidView new_particle_elements("new_particle_elements", nb);
+    particle_structs::MemberTypeViews<Type> new_particles =
+      particle_structs::createMemberViews<Type>(nb);
+    auto new_values = particle_structs::getMemberView<Type, 0>(new_particles);
+    Kokkos::parallel_for(nb, KOKKOS_LAMBDA(const int& i) {
+      new_particle_batches(i) = i;
+      new_particle_elements(i) = 0;
+      new_values(i) = 100 * i;
+    });
+    batch->rebuild(new_element, new_particle_batches, new_particle_elements, new_particles);
+    particle_structs::destroyViews<Type>(new_particles);
+    fail += checkValues(batch, count);
+    if (count != nb * (np + 1)) {
+      printf("[ERROR] Batch has %d particles instead of %d\n", count, nb * (np + 1));
+      ++fail;
+    }
+
+    //The counts of the elements follow the instances
+    auto occupancy = batch->particlesPerElement();
+    auto offsets = batch->elementOffsets();
+    Batch::kkLidView bad_instances("bad_instances", 1);
+    Kokkos::parallel_for(nb, KOKKOS_LAMBDA(const int& b) {
+      lid_t sum = 0;
+      for (lid_t e = offsets(b); e < offsets(b+1); ++e)
+        sum += occupancy(e);
+      if (sum != np + 1)
+        Kokkos::atomic_fetch_add(&bad_instances(0), 1);
+    });
+    if (getLastValue<lid_t>(bad_instances)) {
+      printf("[ERROR] %d instances do not hold %d particles\n",
+             getLastValue<lid_t>(bad_instances), np + 1);
+      ++fail;
+    }
+
+    //Remove the particles of the odd instances
+    Batch::kkLidView remove_element("remove_element", batch->capacity());
+    auto removeParticles = SCS_LAMBDA(const int& b, const int& element_id,
+                                      const int& particle_id, const bool mask) {
+      remove_element(particle_id) = b % 2 ? -1 : element_id;
+    };
+    batch->parallel_for(removeParticles);
+    batch->rebuild(remove_element);
+    fail += checkValues(batch, count);
+    if (count != nb / 2 * (np + 1)) {
+      printf("[ERROR] Batch has %d particles instead of %d\n", count, nb / 2 * (np + 1));
+      ++fail;
+    }
+    delete batch;
+    passed = passed && fail == 0;
+  }
+  Kokkos::finalize();
+  MPI_Finalize();
+  if (!passed)
+    return 1;
+  printf("All tests passed\n");
+  return 0;
+}
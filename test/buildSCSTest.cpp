@@ -12,6 +12,7 @@ using particle_structs::SellCSigma;
 using particle_structs::MemberTypes;
 using particle_structs::distribute_elements;
 using particle_structs::distribute_particles;
+using particle_structs::MyPair;
 
 
 typedef MemberTypes<int> Type;
@@ -21,6 +22,8 @@ typedef SellCSigma<Type,exe_space> SCS;
 bool defaultTest(int ne, int np, SCS::kkLidView ptcls_per_elem, SCS::kkGidView element_gids);
 bool noSortTest(int ne, int np, SCS::kkLidView ptcls_per_elem, SCS::kkGidView element_gids);
 bool largeCTest(int ne, int np, SCS::kkLidView ptcls_per_elem, SCS::kkGidView element_gids);
+bool sigmaSortTest(int ne, int sigma, int scale = 1);
+bool sigmaResortTest(int ne, int sigma, bool ordered = false);
 
 int main(int argc, char* argv[]) {
   MPI_Init(&argc, &argv);
@@ -41,6 +44,16 @@ int main(int argc, char* argv[]) {
     success &= defaultTest(ne, np, ptcls_per_elem_v, element_gids_v);
     success &= noSortTest(ne, np, ptcls_per_elem_v, element_gids_v);
     success &= largeCTest(ne, np, ptcls_per_elem_v, element_gids_v);
+    success &= sigmaSortTest(1000, INT_MAX);
+    success &= sigmaSortTest(1000, 64);
+    success &= sigmaSortTest(1000, 7);
+    success &= sigmaSortTest(1, 64);
+    success &= sigmaSortTest(100000, INT_MAX);
+    success &= sigmaSortTest(100000, 4096, 1 << 20);
+    success &= sigmaResortTest(1000, INT_MAX);
+    success &= sigmaResortTest(1000, 64);
+    success &= sigmaResortTest(1000, 7);
+    success &= sigmaResortTest(1000, 7, true);
   }
   Kokkos::finalize();
   MPI_Finalize();
@@ -132,3 +145,108 @@ bool largeCTest(int ne, int np, SCS::kkLidView ptcls_per_elem, SCS::kkGidView el
   delete scs;
   return f == 0;
 }
+
+//Compares the sort of each sigma window to std::sort on the host
+//  order - the elements in the order the windows are formed, by id when empty
+bool checkSigmaSort(particle_structs::PairView<exe_space> ptcl_pairs, int* counts, int ne,
+                    int sigma, const std::vector<int>& order = std::vector<int>()) {
+  auto pairs_host = particle_structs::deviceToHost(ptcl_pairs);
+  //Sort (count, rank) pairs so ties keep the order, then map the ranks to the elements
+  std::vector<MyPair> expected(ne);
+  for (int i = 0; i < ne; ++i) {
+    expected[i].first = counts[order.empty() ? i : order[i]];
+    expected[i].second = i;
+  }
+  Kokkos::Timer timer;
+  for (int i = 0; i < ne; i += sigma) {
+    const int end = ne - i > sigma ? i + sigma : ne;
+    std::sort(expected.begin() + i, expected.begin() + end);
+  }
+  printf("Host std::sort time: %.6f seconds\n", timer.seconds());
+  if (!order.empty())
+    for (int i = 0; i < ne; ++i)
+      expected[i].second = order[expected[i].second];
+  bool passed = pairs_host.size() == static_cast<std::size_t>(ne);
+  for (int i = 0; passed && i < ne; ++i) {
+    if (pairs_host(i).first != expected[i].first ||
+        pairs_host(i).second != expected[i].second) {
+      printf("Entry %d of the sort is (%d, %d) instead of (%d, %d)\n", i,
+             pairs_host(i).first, pairs_host(i).second,
+             expected[i].first, expected[i].second);
+      passed = false;
+    }
+  }
+  return passed;
+}
+
+//Few distinct counts so most elements tie, scaled to spread the keys over several radix digits
+void setSortCounts(int* counts, int ne, int scale = 1) {
+  for (int i = 0; i < ne; ++i)
+    counts[i] = ((i * 7919) % 53 + (i % 3 == 0) * 1000) * scale;
+}
+
+bool sigmaSortTest(int ne, int sigma, int scale) {
+  printf("\nBeginning Sigma Sort Test with %d elements, sigma %d and count scale %d\n",
+         ne, sigma, scale);
+  int* counts = new int[ne];
+  setSortCounts(counts, ne, scale);
+  SCS::kkLidView ptcls_per_elem("ptcls_per_elem", ne);
+  particle_structs::hostToDevice(ptcls_per_elem, counts);
+  particle_structs::PairView<exe_space> ptcl_pairs;
+  Kokkos::Timer timer;
+  particle_structs::sigmaSort<exe_space>(ptcl_pairs, ne, ptcls_per_elem, sigma);
+  Kokkos::fence();
+  printf("Sigma sort time: %.6f seconds\n", timer.seconds());
+  const bool passed = checkSigmaSort(ptcl_pairs, counts, ne, sigma);
+  delete [] counts;
+  return passed;
+}
+
+//Repairs a sort after changing the counts of a few elements
+//  ordered - forms the windows from a scrambled element order
+bool sigmaResortTest(int ne, int sigma, bool ordered) {
+  printf("\nBeginning Sigma Resort Test with %d elements and sigma %d%s\n", ne, sigma,
+         ordered ? " in a scrambled order" : "");
+  int* counts = new int[ne];
+  setSortCounts(counts, ne);
+  SCS::kkLidView ptcls_per_elem("ptcls_per_elem", ne);
+  particle_structs::hostToDevice(ptcls_per_elem, counts);
+  std::vector<int> order;
+  SCS::kkLidView element_order;
+  if (ordered) {
+    for (int i = 0; i < ne; ++i)
+      order.push_back(i * 7 % ne);
+    element_order = SCS::kkLidView("element_order", ne);
+    particle_structs::hostToDevice(element_order, order.data());
+  }
+  particle_structs::PairView<exe_space> prev_pairs;
+  particle_structs::sigmaSort<exe_space>(prev_pairs, ne, ptcls_per_elem, sigma, element_order);
+
+  bool passed = true;
+  particle_structs::PairView<exe_space> ptcl_pairs;
+  if (!particle_structs::sigmaResort<exe_space>(ptcl_pairs, prev_pairs, ne, ptcls_per_elem,
+                                                sigma, element_order) ||
+      !checkSigmaSort(ptcl_pairs, counts, ne, sigma, order)) {
+    printf("Resort without changes failed\n");
+    passed = false;
+  }
+  for (int i = 0; i < ne; i += 37)
+    counts[i] = counts[i] % 7 ? counts[i] * 3 + 1 : 0;
+  particle_structs::hostToDevice(ptcls_per_elem, counts);
+  if (!particle_structs::sigmaResort<exe_space>(ptcl_pairs, prev_pairs, ne, ptcls_per_elem,
+                                                sigma, element_order) ||
+      !checkSigmaSort(ptcl_pairs, counts, ne, sigma, order)) {
+    printf("Resort with few changes failed\n");
+    passed = false;
+  }
+  for (int i = 0; i < ne; i += 2)
+    counts[i] += 1;
+  particle_structs::hostToDevice(ptcls_per_elem, counts);
+  if (particle_structs::sigmaResort<exe_space>(ptcl_pairs, prev_pairs, ne, ptcls_per_elem,
+                                               sigma, element_order)) {
+    printf("Resort with many changes did not fall back to sigmaSort\n");
+    passed = false;
+  }
+  delete [] counts;
+  return passed;
+}
@@ -3,6 +3,7 @@
 
 #include <MemberTypes.h>
 #include <SellCSigma.h>
+#include <SpeciesGroup.h>
 #include <SCS_Macros.h>
 
 #include <psAssert.h>
@@ -17,8 +18,11 @@ using particle_structs::distribute_elements;
 typedef MemberTypes<int, double[3]> Type;
 typedef Kokkos::DefaultExecutionSpace exe_space;
 typedef SellCSigma<Type, exe_space> SCS;
+typedef MemberTypes<double> Type2;
+typedef SellCSigma<Type2, exe_space> SCS2;
 
 bool sendToOne(int ne, int np);
+bool migrateSpecies(int ne, int np);
 
 int main(int argc, char* argv[]) {
   Kokkos::initialize(argc, argv);
@@ -120,13 +124,17 @@ int main(int argc, char* argv[]) {
     printf("SendToOne failed on rank %d\n", comm_rank);
     fails++;
   }
+  if (!migrateSpecies(50, 1000)) {
+    printf("migrateSpecies failed on rank %d\n", comm_rank);
+    fails++;
+  }
   Kokkos::finalize();
   int total_fails;
   MPI_Reduce(&fails, &total_fails, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
   MPI_Finalize();
   if (comm_rank == 0 && total_fails == 0)
     printf("All tests passed\n");
-  return 0;
+  return fails != 0;
 }
 
 bool sendToOne(int ne, int np) {
@@ -205,3 +213,95 @@ bool sendToOne(int ne, int np) {
   int f = particle_structs::getLastValue(fail);
   return f == 0;
 }
+
+//Migrates two species sharing the element ids of the first one in one round
+bool migrateSpecies(int ne, int np) {
+  int comm_rank;
+  int comm_size;
+  MPI_Comm_rank(MPI_COMM_WORLD, &comm_rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &comm_size);
+
+  //Use gids wider than an int so the messages must carry them whole
+  particle_structs::gid_t* gids = new particle_structs::gid_t[ne];
+  for (int i = 0; i < ne; ++i)
+    gids[i] = (static_cast<particle_structs::gid_t>(1) << 40) + i;
+  int* ptcls_per_elem = new int[ne];
+  std::vector<int>* ids = new std::vector<int>[ne];
+  distribute_particles(ne, np, 0, ptcls_per_elem, ids);
+  delete [] ids;
+
+  SCS::kkLidView ptcls_per_elem_v("ptcls_per_elem_v", ne);
+  SCS::kkGidView element_gids_v("element_gids_v", ne);
+  SCS::kkGidView no_gids_v("no_gids_v", 0);
+  particle_structs::hostToDevice(ptcls_per_elem_v, ptcls_per_elem);
+  particle_structs::hostToDevice(element_gids_v, gids);
+  delete [] ptcls_per_elem;
+  delete [] gids;
+  Kokkos::TeamPolicy<exe_space> po(4, 32);
+  SCS* scs = new SCS(po, ne, 100, ne, np, ptcls_per_elem_v, element_gids_v);
+  SCS2* scs2 = new SCS2(po, ne, 100, ne, np, ptcls_per_elem_v, no_gids_v);
+  particle_structs::SpeciesGroup<exe_space> group;
+  group.addSpecies(scs);
+  group.addSpecies(scs2);
+
+  //The first species sends its first particles to rank 0, the second to the next rank
+  typedef SCS::kkLidView kkLidView;
+  kkLidView new_element("new_element", scs->capacity());
+  kkLidView new_process("new_process", scs->capacity());
+  auto int_slice = scs->get<0>();
+  auto setValues = SCS_LAMBDA(int elem_id, int ptcl_id, int mask) {
+    int_slice(ptcl_id) = 1000 * comm_rank + elem_id;
+    new_process(ptcl_id) = ptcl_id < np / 10 ? 0 : comm_rank;
+    new_element(ptcl_id) = elem_id;
+  };
+  scs->parallel_for(setValues);
+  kkLidView new_element2("new_element2", scs2->capacity());
+  kkLidView new_process2("new_process2", scs2->capacity());
+  auto double_slice = scs2->get<0>();
+  auto setValues2 = SCS_LAMBDA(int elem_id, int ptcl_id, int mask) {
+    double_slice(ptcl_id) = elem_id + 0.5;
+    new_process2(ptcl_id) = ptcl_id < np / 10 ? (comm_rank + 1) % comm_size : comm_rank;
+    new_element2(ptcl_id) = (elem_id + 1) % ne;
+  };
+  scs2->parallel_for(setValues2);
+
+  std::vector<kkLidView> new_elements = {new_element, new_element2};
+  std::vector<kkLidView> new_processes = {new_process, new_process2};
+  group.migrate(new_elements, new_processes);
+
+  //Every element has the same number of particles so the first slots are full
+  bool passed = true;
+  const int expected = comm_rank == 0 ? np + (comm_size - 1) * (np / 10) : np - np / 10;
+  if (scs->nPtcls() != expected) {
+    fprintf(stderr, "Rank %d has %d particles of the first species instead of %d\n",
+            comm_rank, scs->nPtcls(), expected);
+    passed = false;
+  }
+  if (comm_size > 1 && scs2->nPtcls() != np) {
+    fprintf(stderr, "Rank %d has %d particles of the second species instead of %d\n",
+            comm_rank, scs2->nPtcls(), np);
+    passed = false;
+  }
+  int_slice = scs->get<0>();
+  double_slice = scs2->get<0>();
+  kkLidView fail("fail", 1);
+  auto checkValues = SCS_LAMBDA(int elem_id, int ptcl_id, int mask) {
+    if (mask && int_slice(ptcl_id) % 1000 != elem_id) {
+      printf("%d First species particle %d in element %d has value %d\n", comm_rank,
+             ptcl_id, elem_id, int_slice(ptcl_id));
+      fail(0) = 1;
+    }
+  };
+  scs->parallel_for(checkValues);
+  auto checkValues2 = SCS_LAMBDA(int elem_id, int ptcl_id, int mask) {
+    if (mask && double_slice(ptcl_id) != (elem_id + ne - 1) % ne + 0.5) {
+      printf("%d Second species particle %d in element %d has value %f\n", comm_rank,
+             ptcl_id, elem_id, double_slice(ptcl_id));
+      fail(0) = 1;
+    }
+  };
+  scs2->parallel_for(checkValues2);
+  delete scs;
+  delete scs2;
+  return passed && particle_structs::getLastValue(fail) == 0;
+}
@@ -21,6 +21,22 @@ typedef SellCSigma<Type,exe_space> SCS;
 bool shuffleParticlesTests();
 bool resortElementsTest();
 bool reshuffleTests();
+bool tiledMembersTest();
+bool inPlaceRebuildTest();
+bool capacityPolicyTest();
+bool heavyElementsTest(const char* name, particle_structs::CapacityPolicy cap_policy);
+bool skipEmptyTest();
+bool fixedChunkTest();
+bool wideIndexTest();
+bool localRegrowthTest(double over_allocation);
+bool coldMembersTest();
+bool slotElementsTest();
+bool activeSlotsTest();
+bool elementArrayTest();
+bool occupancyTest();
+bool snapshotTest();
+bool elementOrderTest();
+bool sortedRebuildTest();
 
 int main(int argc, char* argv[]) {
   MPI_Init(&argc, &argv);
@@ -39,12 +55,88 @@ int main(int argc, char* argv[]) {
     passed = false;
     printf("[ERROR] reshuffleTests() failed\n");
   }
+  if (!tiledMembersTest()) {
+    passed = false;
+    printf("[ERROR] tiledMembersTest() failed\n");
+  }
+  if (!inPlaceRebuildTest()) {
+    passed = false;
+    printf("[ERROR] inPlaceRebuildTest() failed\n");
+  }
+  if (!capacityPolicyTest()) {
+    passed = false;
+    printf("[ERROR] capacityPolicyTest() failed\n");
+  }
+  //Cap rows at 8 slots so the heavy elements of the distribution spill over
+  if (!heavyElementsTest("Overflow", particle_structs::CapacityPolicy(1.1, 0, 0, 0, 8))) {
+    passed = false;
+    printf("[ERROR] heavyElementsTest(Overflow) failed\n");
+  }
+  //Split the heavy elements into rows of at most 8 slots
+  if (!heavyElementsTest("Split Rows",
+                         particle_structs::CapacityPolicy(1.1, 0, 0, 0, 8, true))) {
+    passed = false;
+    printf("[ERROR] heavyElementsTest(Split Rows) failed\n");
+  }
+  if (!skipEmptyTest()) {
+    passed = false;
+    printf("[ERROR] skipEmptyTest() failed\n");
+  }
+  if (!fixedChunkTest()) {
+    passed = false;
+    printf("[ERROR] fixedChunkTest() failed\n");
+  }
+  if (!wideIndexTest()) {
+    passed = false;
+    printf("[ERROR] wideIndexTest() failed\n");
+  }
+  //Without over allocation the members are copied, with it they keep their allocation
+  if (!localRegrowthTest(1.0)) {
+    passed = false;
+    printf("[ERROR] localRegrowthTest(1.0) failed\n");
+  }
+  if (!localRegrowthTest(2.0)) {
+    passed = false;
+    printf("[ERROR] localRegrowthTest(2.0) failed\n");
+  }
+  if (!coldMembersTest()) {
+    passed = false;
+    printf("[ERROR] coldMembersTest() failed\n");
+  }
+  if (!slotElementsTest()) {
+    passed = false;
+    printf("[ERROR] slotElementsTest() failed\n");
+  }
+  if (!activeSlotsTest()) {
+    passed = false;
+    printf("[ERROR] activeSlotsTest() failed\n");
+  }
+  if (!elementArrayTest()) {
+    passed = false;
+    printf("[ERROR] elementArrayTest() failed\n");
+  }
+  if (!occupancyTest()) {
+    passed = false;
+    printf("[ERROR] occupancyTest() failed\n");
+  }
+  if (!snapshotTest()) {
+    passed = false;
+    printf("[ERROR] snapshotTest() failed\n");
+  }
+  if (!elementOrderTest()) {
+    passed = false;
+    printf("[ERROR] elementOrderTest() failed\n");
+  }
+  if (!sortedRebuildTest()) {
+    passed = false;
+    printf("[ERROR] sortedRebuildTest() failed\n");
+  }
 
   Kokkos::finalize();
   MPI_Finalize();
   if (passed)
     printf("All tests passed\n");
-  return 0;
+  return passed ? 0 : 1;
 }
 
 
@@ -289,6 +381,8 @@ bool reshuffleTests() {
   
   //Remove all particles from element 0 & 2, move particles from 1 & 3 to 0 & 2
   printf("\nDump and redistribute particles");
+  //Count and sum the ids of the particles on the odd elements, which are the ones that remain
+  SCS::kkLidView kept("kept", 2);
   auto dumpAndRedistribute = SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
     if (!mask) {
       printf("[ERROR] Missing particle %d\n", particle_id);
@@ -296,31 +390,1130 @@ bool reshuffleTests() {
     }
     if (pids(particle_id) == 100 && element_id != 2) {
       printf("[ERROR] New particle 100 was not inserted into correct element\n");
+      fail(0) = 1;
     }
     if (pids(particle_id) == 200 && element_id != 3) {
       printf("[ERROR] New particle 200 was not inserted into correct element\n");
+      fail(0) = 1;
     }
     if (element_id % 2 == 0)
       new_element(particle_id) = -1;
-    else
+    else {
       new_element(particle_id) = element_id / 2 * 2;
+      if (mask) {
+        Kokkos::atomic_fetch_add(&kept(0), 1);
+        Kokkos::atomic_fetch_add(&kept(1), pids(particle_id));
+      }
+    }
   };
   scs->parallel_for(dumpAndRedistribute);
 
   scs->rebuild(new_element);
   scs->printFormat();
 
+  SCS::kkLidView remaining("remaining", 2);
   auto checkFinal = SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
     if (mask) {
       if (element_id % 2 == 1) {
         printf("[ERROR] Particle %d remains on element %d\n", particle_id, element_id);
+        fail(0) = 1;
       }
-      if (pids(particle_id) % 2 != 0) {
-        printf("[ERROR] Odd Particle %d remains on element %d\n", particle_id, element_id);
-      }
+      Kokkos::atomic_fetch_add(&remaining(0), 1);
+      Kokkos::atomic_fetch_add(&remaining(1), pids(particle_id));
     }
   };
   scs->parallel_for(checkFinal);
+  SCS::kkLidHostMirror kept_h = Kokkos::create_mirror_view(kept);
+  SCS::kkLidHostMirror remaining_h = Kokkos::create_mirror_view(remaining);
+  Kokkos::deep_copy(kept_h, kept);
+  Kokkos::deep_copy(remaining_h, remaining);
   int f = particle_structs::getLastValue<lid_t>(fail);
+  if (remaining_h(0) != kept_h(0) || remaining_h(1) != kept_h(1)) {
+    printf("[ERROR] %d particles with id sum %d remain instead of the %d particles with id sum %d "
+           "of the odd elements\n", remaining_h(0), remaining_h(1), kept_h(0), kept_h(1));
+    f = 1;
+  }
   return !f;
 }
+
+/* Creates a structure of ne elements holding np particles spread by distribution (see
+   distribute_particles) and sets the first member of each particle to its element
+*/
+template <class SCSType>
+SCSType* makeSCS(int ne, int np, int sigma, int V,
+                 particle_structs::CapacityPolicy cap_policy = particle_structs::CapacityPolicy(),
+                 int distribution = 0) {
+  typedef typename SCSType::lid_t scs_lid_t;
+  int* ptcls_per_elem = new int[ne];
+  std::vector<int>* ids = new std::vector<int>[ne];
+  distribute_particles(ne, np, distribution, ptcls_per_elem, ids);
+
+  Kokkos::TeamPolicy<exe_space> po(128, 4);
+  typename SCSType::kkLidView ptcls_per_elem_v("ptcls_per_elem_v", ne);
+  typename SCSType::kkGidView element_gids_v("element_gids_v", 0);
+  auto ptcls_per_elem_h = Kokkos::create_mirror_view(ptcls_per_elem_v);
+  for (int i = 0; i < ne; ++i)
+    ptcls_per_elem_h(i) = ptcls_per_elem[i];
+  Kokkos::deep_copy(ptcls_per_elem_v, ptcls_per_elem_h);
+  delete [] ptcls_per_elem;
+  delete [] ids;
+
+  SCSType* scs = new SCSType(po, sigma, V, ne, np, ptcls_per_elem_v, element_gids_v, {}, {},
+                             cap_policy);
+  auto values = scs->template get<0>();
+  auto setValues = SCS_LAMBDA(const scs_lid_t& element_id, const scs_lid_t& particle_id,
+                              const bool mask) {
+    values(particle_id) = element_id;
+  };
+  scs->parallel_for(setValues);
+  return scs;
+}
+
+//Returns the new element fn(element_id, particle_id, mask) of every slot for a rebuild
+template <class SCSType, typename ElementFunction>
+typename SCSType::kkLidView newElements(SCSType* scs, ElementFunction fn) {
+  typedef typename SCSType::lid_t scs_lid_t;
+  typename SCSType::kkLidView new_element("new_element", scs->capacity());
+  auto setNewElement = SCS_LAMBDA(const scs_lid_t& element_id, const scs_lid_t& particle_id,
+                                  const bool mask) {
+    new_element(particle_id) = fn(element_id, particle_id, mask);
+  };
+  scs->parallel_for(setNewElement);
+  return new_element;
+}
+
+//Rebuilds the structure with every particle moved to the element fn gives it
+template <class SCSType, typename ElementFunction>
+void moveParticles(SCSType* scs, ElementFunction fn) {
+  scs->rebuild(newElements(scs, fn));
+}
+
+typedef MemberTypes<int, double[3]> TiledType;
+typedef SellCSigma<TiledType, exe_space> TiledSCS;
+
+//Checks that the position of each particle was set from its id
+int checkTiledValues(TiledSCS* scs) {
+  TiledSCS::kkLidView fail("fail", 1);
+  auto pids = scs->get<0>();
+  auto pos = scs->get<1>();
+  auto checkValues = SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    if (mask) {
+      for (int i = 0; i < 3; ++i) {
+        if (pos(particle_id, i) != pids(particle_id) + i * 0.25) {
+          printf("[ERROR] Particle %d has wrong component %d (%f)\n", pids(particle_id), i,
+                 pos(particle_id, i));
+          fail(0) = 1;
+        }
+      }
+    }
+  };
+  scs->parallel_for(checkValues);
+  return getLastValue<lid_t>(fail);
+}
+
+bool tiledMembersTest() {
+  printf("\n\nTiled Members Test\n");
+  int ne = 5;
+  int np = 20;
+  TiledSCS* scs = makeSCS<TiledSCS>(ne, np, 5, 2, particle_structs::CapacityPolicy(), 2);
+  auto pids = scs->get<0>();
+  auto pos = scs->get<1>();
+  auto setValues = SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    pids(particle_id) = particle_id;
+    for (int i = 0; i < 3; ++i)
+      pos(particle_id, i) = particle_id + i * 0.25;
+  };
+  scs->parallel_for(setValues);
+
+  //Switch to the tiled layout and check the values survive the relayout
+  scs->setMemberTiling(true);
+  if (scs->tileHeight() != scs->C()) {
+    printf("[ERROR] Tile height %d does not match C %d\n", scs->tileHeight(), scs->C());
+    return false;
+  }
+  int fail = checkTiledValues(scs);
+
+  //Force a full rebuild that moves every particle
+  scs->setShuffling(false);
+  moveParticles(scs, SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    return (element_id + 1) % ne;
+  });
+  fail += checkTiledValues(scs);
+
+  //Return to the native layout
+  scs->setMemberTiling(false);
+  fail += checkTiledValues(scs);
+  delete scs;
+  return fail == 0;
+}
+
+bool inPlaceRebuildTest() {
+  printf("\n\nIn Place Rebuild Test\n");
+  int ne = 5;
+  int np = 20;
+  TiledSCS* scs = makeSCS<TiledSCS>(ne, np, 5, 2, particle_structs::CapacityPolicy(), 2);
+  scs->setInPlaceRebuild(true);
+  scs->setShuffling(false);
+  auto pids = scs->get<0>();
+  auto pos = scs->get<1>();
+  auto setValues = SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    pids(particle_id) = particle_id;
+    for (int i = 0; i < 3; ++i)
+      pos(particle_id, i) = particle_id + i * 0.25;
+  };
+  scs->parallel_for(setValues);
+
+  //Move every particle to the next element
+  moveParticles(scs, SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    return (element_id + 1) % ne;
+  });
+  int fail = checkTiledValues(scs);
+
+  //Relayout the members without the swap views
+  scs->setMemberTiling(true);
+  fail += checkTiledValues(scs);
+
+  //Gather every particle in one element so the capacity grows
+  moveParticles(scs, SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    return 0;
+  });
+  fail += checkTiledValues(scs);
+  if (scs->nPtcls() != np) {
+    printf("[ERROR] In place rebuild has %d particles instead of %d\n", scs->nPtcls(), np);
+    ++fail;
+  }
+  delete scs;
+  return fail == 0;
+}
+
+bool capacityPolicyTest() {
+  printf("\n\nCapacity Policy Test\n");
+  int ne = 5;
+  int np = 20;
+  //Reserve 3 empty slots per row and shrink when less than half the allocation is used
+  const int slack = 3;
+  particle_structs::CapacityPolicy cap_policy(1.1, 0.5, 0, slack);
+  SCS* scs = makeSCS<SCS>(ne, np, 5, 2, cap_policy);
+  auto stay = SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    return element_id;
+  };
+
+  //Rebuild to reserve the slack in each row
+  scs->setShuffling(false);
+  moveParticles(scs, stay);
+
+  //Add slack new particles to every element which must fit without a rebuild
+  const int nnew = ne * slack;
+  SCS::kkLidView new_particle_elements("new_particle_elements", nnew);
+  particle_structs::MemberTypeViews<Type> new_particles =
+    particle_structs::createMemberViews<Type>(nnew);
+  auto new_values = particle_structs::getMemberView<Type, 0>(new_particles);
+  Kokkos::parallel_for(nnew, KOKKOS_LAMBDA(const int& i) {
+    new_particle_elements(i) = i % ne;
+    new_values(i) = i % ne;
+  });
+  int fail = 0;
+  if (!scs->reshuffle(newElements(scs, stay), new_particle_elements, new_particles)) {
+    printf("[ERROR] Reshuffle did not fit the new particles into the row slack\n");
+    ++fail;
+  }
+  particle_structs::destroyViews<Type>(new_particles);
+  if (scs->nPtcls() != np + nnew) {
+    printf("[ERROR] Structure has %d particles instead of %d\n", scs->nPtcls(), np + nnew);
+    ++fail;
+  }
+
+  //Remove all particles outside the first element to trigger a shrink
+  const lid_t old_capacity = scs->capacity();
+  const std::size_t old_allocation = scs->memberAllocation();
+  moveParticles(scs, SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    return element_id == 0 ? 0 : -1;
+  });
+  SCS::kkLidView bad("bad", 1);
+  auto values = scs->get<0>();
+  auto checkValues = SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    if (mask && (element_id != 0 || values(particle_id) != 0))
+      bad(0) = 1;
+  };
+  scs->parallel_for(checkValues);
+  fail += getLastValue<lid_t>(bad);
+  if (scs->nPtcls() != np / ne + slack) {
+    printf("[ERROR] Structure has %d particles after removal instead of %d\n", scs->nPtcls(),
+           np / ne + slack);
+    ++fail;
+  }
+  //The capacity fell below the shrink threshold so the members are reallocated to fit it
+  if (scs->capacity() >= cap_policy.shrink_threshold * old_allocation) {
+    printf("[ERROR] Capacity went from %d to %d which does not trigger a shrink of %lu\n",
+           old_capacity, scs->capacity(), old_allocation);
+    ++fail;
+  }
+  if (scs->memberAllocation() != cap_policy.allocation(scs->capacity())) {
+    printf("[ERROR] Members hold %lu entries after the shrink instead of %lu\n",
+           scs->memberAllocation(), cap_policy.allocation(scs->capacity()));
+    ++fail;
+  }
+  delete scs;
+  return fail == 0;
+}
+
+//Checks that every particle is in the element stored in its value and counts the particles
+template <class SCSType>
+int checkElementValues(SCSType* scs, lid_t& count) {
+  typedef typename SCSType::lid_t scs_lid_t;
+  typename SCSType::kkLidView fail("fail", 1);
+  typename SCSType::kkLidView num("num", 1);
+  auto values = scs->template get<0>();
+  auto checkValues = SCS_LAMBDA(const scs_lid_t& element_id, const scs_lid_t& particle_id,
+                                const bool mask) {
+    if (mask) {
+      Kokkos::atomic_fetch_add(&num(0), 1);
+      if (values(particle_id) != element_id) {
+        printf("[ERROR] Particle %ld of element %d is in element %ld\n", (long)particle_id,
+               values(particle_id), (long)element_id);
+        fail(0) = 1;
+      }
+    }
+  };
+  scs->parallel_for(checkValues);
+  count = getLastValue<scs_lid_t>(num);
+  return getLastValue<scs_lid_t>(fail);
+}
+
+bool heavyElementsTest(const char* name, particle_structs::CapacityPolicy cap_policy) {
+  printf("\n\n%s Test\n", name);
+  int ne = 10;
+  int np = 200;
+  SCS* scs = makeSCS<SCS>(ne, np, 5, 2, cap_policy, 2);
+  scs->printFormat();
+  scs->printMetrics();
+  int fail = 0;
+  if ((scs->nOverflow() > 0) != cap_policy.hasOverflow()) {
+    printf("[ERROR] Overflow region has %d slots\n", scs->nOverflow());
+    ++fail;
+  }
+  lid_t count;
+  fail += checkElementValues(scs, count);
+  if (count != np) {
+    printf("[ERROR] parallel_for visited %d particles instead of %d\n", count, np);
+    ++fail;
+  }
+
+  //Send every particle to the next element with a full rebuild
+  auto values = scs->get<0>();
+  scs->setShuffling(false);
+  moveParticles(scs, SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    values(particle_id) = (element_id + 1) % ne;
+    return (element_id + 1) % ne;
+  });
+  fail += checkElementValues(scs, count);
+  if (count != np || scs->nPtcls() != np) {
+    printf("[ERROR] Rebuild kept %d particles instead of %d\n", count, np);
+    ++fail;
+  }
+
+  //Reshuffle the particles at the end of the structure back to the first element
+  values = scs->get<0>();
+  const lid_t tail_start = scs->capacity() - scs->capacity() / 4;
+  scs->setShuffling(true);
+  moveParticles(scs, SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    if (!mask || particle_id < tail_start)
+      return element_id;
+    values(particle_id) = 0;
+    return 0;
+  });
+  fail += checkElementValues(scs, count);
+  if (count != np || scs->nPtcls() != np) {
+    printf("[ERROR] Reshuffle kept %d particles instead of %d\n", count, np);
+    ++fail;
+  }
+  delete scs;
+  return fail == 0;
+}
+
+bool skipEmptyTest() {
+  printf("\n\nSkip Empty Elements Test\n");
+  //Half of the elements start without particles
+  int ne = 20;
+  int np = 10;
+  particle_structs::CapacityPolicy cap_policy(1.1, 0, 0, 0, 0, false, true);
+  SCS* scs = makeSCS<SCS>(ne, np, 5, 2, cap_policy);
+  scs->printFormat();
+  int fail = 0;
+  if (scs->numRows() >= ne) {
+    printf("[ERROR] Empty elements were given rows (%d rows)\n", scs->numRows());
+    ++fail;
+  }
+  lid_t count;
+  fail += checkElementValues(scs, count);
+
+  //Send every particle to an element without a row
+  auto values = scs->get<0>();
+  moveParticles(scs, SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    values(particle_id) = (element_id + ne / 2) % ne;
+    return (element_id + ne / 2) % ne;
+  });
+  scs->printFormat();
+  fail += checkElementValues(scs, count);
+  if (count != np || scs->nPtcls() != np) {
+    printf("[ERROR] Rebuild kept %d particles instead of %d\n", count, np);
+    ++fail;
+  }
+  if (scs->numRows() >= ne) {
+    printf("[ERROR] Emptied elements kept their rows (%d rows)\n", scs->numRows());
+    ++fail;
+  }
+  delete scs;
+  return fail == 0;
+}
+
+typedef SellCSigma<Type, exe_space, 4, 2> FixedSCS;
+
+bool fixedChunkTest() {
+  printf("\n\nFixed Chunk Height Test\n");
+  int ne = 10;
+  int np = 50;
+  //The vertical slice width given at runtime is ignored
+  FixedSCS* scs = makeSCS<FixedSCS>(ne, np, 5, 1024, particle_structs::CapacityPolicy(), 2);
+  int fail = 0;
+  if (scs->C() != 4 || scs->V() != 2) {
+    printf("[ERROR] SCS was built with C %d and V %d instead of 4 and 2\n", scs->C(), scs->V());
+    ++fail;
+  }
+  lid_t count;
+  fail += checkElementValues(scs, count);
+  if (count != np) {
+    printf("[ERROR] parallel_for visited %d particles instead of %d\n", count, np);
+    ++fail;
+  }
+
+  //Move every particle to the next element
+  auto values = scs->get<0>();
+  moveParticles(scs, SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    values(particle_id) = (element_id + 1) % ne;
+    return (element_id + 1) % ne;
+  });
+  fail += checkElementValues(scs, count);
+  if (count != np || scs->C() != 4) {
+    printf("[ERROR] Rebuild kept %d particles with C %d\n", count, scs->C());
+    ++fail;
+  }
+  delete scs;
+  return fail == 0;
+}
+
+typedef SellCSigma<Type, exe_space, 0, 0, long> WideSCS;
+
+bool wideIndexTest() {
+  printf("\n\n64 Bit Index Test\n");
+  int ne = 10;
+  int np = 50;
+  WideSCS* scs = makeSCS<WideSCS>(ne, np, 5, 2, particle_structs::CapacityPolicy(), 2);
+  scs->printFormat();
+  int fail = 0;
+  lid_t count;
+  fail += checkElementValues(scs, count);
+  if (count != np) {
+    printf("[ERROR] parallel_for visited %d particles instead of %d\n", count, np);
+    ++fail;
+  }
+
+  //Move every particle to the next element
+  auto values = scs->get<0>();
+  moveParticles(scs, SCS_LAMBDA(const long& element_id, const long& particle_id,
+                                const bool mask) {
+    values(particle_id) = (element_id + 1) % ne;
+    return (element_id + 1) % ne;
+  });
+  fail += checkElementValues(scs, count);
+  if (count != np || scs->nPtcls() != np) {
+    printf("[ERROR] Rebuild kept %d particles instead of %d\n", count, np);
+    ++fail;
+  }
+  delete scs;
+
+  //Sizes above INT_MAX are not truncated by the capacity policy or getLastValue
+  const long big = static_cast<long>(INT_MAX) + 2;
+  particle_structs::CapacityPolicy wide_policy(1.5, 0.5);
+  if (wide_policy.allocation(big) != static_cast<std::size_t>(big * 1.5) ||
+      wide_policy.reallocation(big, big) != static_cast<std::size_t>(big) ||
+      wide_policy.reallocation(big, 4 * big) != wide_policy.allocation(big)) {
+    printf("[ERROR] Capacity policy truncated a capacity of %ld\n", big);
+    ++fail;
+  }
+  Kokkos::View<char*, exe_space::device_type> bytes(
+    Kokkos::ViewAllocateWithoutInitializing("bytes"), big);
+  Kokkos::parallel_for(1, KOKKOS_LAMBDA(const int& i) {
+    bytes(big - 1) = 7;
+  });
+  if (getLastValue(bytes) != 7) {
+    printf("[ERROR] getLastValue did not read entry %ld\n", big - 1);
+    ++fail;
+  }
+  return fail == 0;
+}
+
+bool localRegrowthTest(double over_allocation) {
+  printf("\n\nLocal Regrowth Test (over allocation %.1f)\n", over_allocation);
+  int ne = 10;
+  int np = 40;
+  particle_structs::CapacityPolicy cap_policy(over_allocation);
+  SCS* scs = makeSCS<SCS>(ne, np, 1, 2, cap_policy);
+  scs->setLocalRegrowth(true);
+  scs->printFormat();
+
+  //Send the particles of element 1 to element 0, the other particles stay in their slots
+  const lid_t old_capacity = scs->capacity();
+  const std::size_t old_allocation = scs->memberAllocation();
+  SCS::kkLidView stay_value("stay_value", scs->capacity());
+  auto values = scs->get<0>();
+  moveParticles(scs, SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    const int new_elem = element_id == 1 ? 0 : element_id;
+    values(particle_id) = new_elem;
+    stay_value(particle_id) = (mask && new_elem == element_id) ? element_id : -1;
+    return new_elem;
+  });
+  scs->printFormat();
+
+  int fail = 0;
+  lid_t count;
+  fail += checkElementValues(scs, count);
+  if (count != np || scs->nPtcls() != np) {
+    printf("[ERROR] Regrowth kept %d particles instead of %d\n", count, np);
+    ++fail;
+  }
+  if (scs->capacity() <= old_capacity) {
+    printf("[ERROR] The chunk of element 0 did not grow (capacity %d)\n", scs->capacity());
+    ++fail;
+  }
+  //The members are only reallocated when the new slices do not fit in the allocation
+  const bool fits = static_cast<std::size_t>(scs->capacity()) <= old_allocation;
+  if (fits != (scs->memberAllocation() == old_allocation)) {
+    printf("[ERROR] Members hold %lu entries for capacity %d after holding %lu\n",
+           scs->memberAllocation(), scs->capacity(), old_allocation);
+    ++fail;
+  }
+  if (over_allocation > 1.0 && !fits) {
+    printf("[ERROR] Capacity %d outgrew the over allocation of %lu entries\n",
+           scs->capacity(), old_allocation);
+    ++fail;
+  }
+  SCS::kkLidView moved("moved", 1);
+  values = scs->get<0>();
+  auto checkStayed = SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    if (particle_id < old_capacity && stay_value(particle_id) != -1 &&
+        (!mask || values(particle_id) != stay_value(particle_id)))
+      moved(0) = 1;
+  };
+  scs->parallel_for(checkStayed);
+  if (getLastValue<lid_t>(moved)) {
+    printf("[ERROR] Particles outside of the grown chunk were moved\n");
+    ++fail;
+  }
+  delete scs;
+  return fail == 0;
+}
+
+bool coldMembersTest() {
+  printf("\n\nCold Members Test\n");
+  int ne = 5;
+  int np = 20;
+  TiledSCS* scs = makeSCS<TiledSCS>(ne, np, 5, 2, particle_structs::CapacityPolicy(), 2);
+  auto pids = scs->get<0>();
+  auto pos = scs->get<1>();
+  auto setValues = SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    pids(particle_id) = particle_id;
+    for (int i = 0; i < 3; ++i)
+      pos(particle_id, i) = particle_id + i * 0.25;
+  };
+  scs->parallel_for(setValues);
+
+  //The ids stay in place while the positions follow the particles
+  scs->setColdMembers(1u);
+
+  //Move every particle to the next element
+  auto nextElement = SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    return (element_id + 1) % ne;
+  };
+  moveParticles(scs, nextElement);
+
+  //Move the particles again with a full rebuild and add new particles to element 0
+  const int nnew = 4;
+  TiledSCS::kkLidView new_particle_elements("new_particle_elements", nnew);
+  particle_structs::MemberTypeViews<TiledType> new_particles =
+    particle_structs::createMemberViews<TiledType>(nnew);
+  auto new_pids = particle_structs::getMemberView<TiledType, 0>(new_particles);
+  auto new_pos = particle_structs::getMemberView<TiledType, 1>(new_particles);
+  Kokkos::parallel_for(nnew, KOKKOS_LAMBDA(const int& i) {
+    new_pids(i) = 1000 + i;
+    for (int j = 0; j < 3; ++j)
+      new_pos(i, j) = 1000 + i + j * 0.25;
+  });
+  auto secondElement = SCS_LAMBDA(const int& element_id, const int& particle_id,
+                                  const bool mask) {
+    return (element_id + 2) % ne;
+  };
+  scs->setShuffling(false);
+  scs->rebuild(newElements(scs, secondElement), new_particle_elements, new_particles);
+
+  //Reading the ids permutes them into slot order
+  int fail = checkTiledValues(scs);
+  if (scs->nPtcls() != np + nnew) {
+    printf("[ERROR] Cold members test has %d particles instead of %d\n", scs->nPtcls(),
+           np + nnew);
+    ++fail;
+  }
+
+  //Permute the ids after every rebuild without the swap views
+  scs->setColdMembers(1u, 1);
+  scs->setInPlaceRebuild(true);
+  scs->rebuild(newElements(scs, nextElement), new_particle_elements, new_particles);
+  fail += checkTiledValues(scs);
+  particle_structs::destroyViews<TiledType>(new_particles);
+  delete scs;
+
+  //Keep the tiled positions cold without over allocation, the three new particles end the
+  //  grown cold entries in a partly used tile
+  TiledSCS* tiled = makeSCS<TiledSCS>(ne, np, 5, 2, particle_structs::CapacityPolicy(1.0), 2);
+  tiled->setMemberTiling(true);
+  auto tiled_pids = tiled->get<0>();
+  auto tiled_pos = tiled->get<1>();
+  auto setTiledValues = SCS_LAMBDA(const int& element_id, const int& particle_id,
+                                   const bool mask) {
+    tiled_pids(particle_id) = particle_id;
+    for (int i = 0; i < 3; ++i)
+      tiled_pos(particle_id, i) = particle_id + i * 0.25;
+  };
+  tiled->parallel_for(setTiledValues);
+  tiled->setColdMembers(2u);
+  const int nodd = 3;
+  TiledSCS::kkLidView odd_particle_elements("odd_particle_elements", nodd);
+  particle_structs::MemberTypeViews<TiledType> odd_particles =
+    particle_structs::createMemberViews<TiledType>(nodd);
+  auto odd_pids = particle_structs::getMemberView<TiledType, 0>(odd_particles);
+  auto odd_pos = particle_structs::getMemberView<TiledType, 1>(odd_particles);
+  Kokkos::parallel_for(nodd, KOKKOS_LAMBDA(const int& i) {
+    odd_particle_elements(i) = i;
+    odd_pids(i) = 2000 + i;
+    for (int j = 0; j < 3; ++j)
+      odd_pos(i, j) = 2000 + i + j * 0.25;
+  });
+  tiled->rebuild(newElements(tiled, nextElement), odd_particle_elements, odd_particles);
+  fail += checkTiledValues(tiled);
+  if (tiled->nPtcls() != np + nodd) {
+    printf("[ERROR] Tiled cold members test has %d particles instead of %d\n",
+           tiled->nPtcls(), np + nodd);
+    ++fail;
+  }
+  particle_structs::destroyViews<TiledType>(odd_particles);
+  delete tiled;
+  return fail == 0;
+}
+
+//Checks that parallel_for_flat gives every slot the element parallel_for gives it
+int checkSlotElements(SCS* scs, lid_t& count) {
+  SCS::kkLidView slot_element("slot_element", scs->capacity());
+  auto setSlotElement = SCS_LAMBDA(const int& element_id, const int& particle_id,
+                                   const bool mask) {
+    slot_element(particle_id) = element_id;
+  };
+  scs->parallel_for(setSlotElement);
+  SCS::kkLidView fail("fail", 1);
+  SCS::kkLidView num("num", 1);
+  auto checkSlot = SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    Kokkos::atomic_fetch_add(&num(0), mask);
+    if (slot_element(particle_id) != element_id) {
+      printf("[ERROR] Slot %d is in element %d instead of %d\n", particle_id, element_id,
+             slot_element(particle_id));
+      fail(0) = 1;
+    }
+  };
+  scs->parallel_for_flat(checkSlot);
+  count = getLastValue<lid_t>(num);
+  return getLastValue<lid_t>(fail);
+}
+
+bool slotElementsTest() {
+  printf("\n\nSlot Elements Test\n");
+  int ne = 10;
+  int np = 200;
+  //Cap the rows so the flat loop also covers the overflow slots
+  particle_structs::CapacityPolicy cap_policy(1.1, 0, 0, 0, 8);
+  SCS* scs = makeSCS<SCS>(ne, np, 5, 2, cap_policy, 2);
+  scs->setSlotElements(true);
+  lid_t count;
+  int fail = checkSlotElements(scs, count);
+  if (count != np) {
+    printf("[ERROR] The flat loop visited %d particles instead of %d\n", count, np);
+    ++fail;
+  }
+
+  //Gather the particles in the first two elements so the layout changes
+  moveParticles(scs, SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    return element_id % 2;
+  });
+  fail += checkSlotElements(scs, count);
+  if (count != np) {
+    printf("[ERROR] The flat loop visited %d particles instead of %d after rebuild\n", count, np);
+    ++fail;
+  }
+
+  //Without the slot elements the flat loop falls back to parallel_for
+  scs->setSlotElements(false);
+  fail += checkSlotElements(scs, count);
+  delete scs;
+  return fail == 0;
+}
+
+//Checks that parallel_for_active visits each particle once with its element
+int checkActiveSlots(SCS* scs, lid_t& count) {
+  SCS::kkLidView visits("visits", scs->capacity());
+  auto values = scs->get<0>();
+  SCS::kkLidView fail("fail", 1);
+  auto visitParticle = SCS_LAMBDA(const int& element_id, const int& particle_id,
+                                  const bool mask) {
+    Kokkos::atomic_fetch_add(&visits(particle_id), 1);
+    if (!mask || values(particle_id) != element_id) {
+      printf("[ERROR] Active slot %d has mask %d and value %d in element %d\n", particle_id,
+             mask, values(particle_id), element_id);
+      fail(0) = 1;
+    }
+  };
+  scs->parallel_for_active(visitParticle);
+  SCS::kkLidView num("num", 1);
+  auto checkVisits = SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    Kokkos::atomic_fetch_add(&num(0), visits(particle_id));
+    if (visits(particle_id) != mask) {
+      printf("[ERROR] Slot %d with mask %d was visited %d times\n", particle_id, mask,
+             visits(particle_id));
+      fail(0) = 1;
+    }
+  };
+  scs->parallel_for(checkVisits);
+  count = getLastValue<lid_t>(num);
+  return getLastValue<lid_t>(fail);
+}
+
+bool activeSlotsTest() {
+  printf("\n\nActive Slots Test\n");
+  int ne = 10;
+  int np = 200;
+  SCS* scs = makeSCS<SCS>(ne, np, 5, 2, particle_structs::CapacityPolicy(), 2);
+  scs->setActiveSlots(true);
+  lid_t count;
+  int fail = checkActiveSlots(scs, count);
+  if (count != np) {
+    printf("[ERROR] The active loop visited %d particles instead of %d\n", count, np);
+    ++fail;
+  }
+
+  //Remove every other particle with a reshuffle
+  moveParticles(scs, SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    return particle_id % 2 ? -1 : element_id;
+  });
+  fail += checkActiveSlots(scs, count);
+  if (count != scs->nPtcls()) {
+    printf("[ERROR] The active loop visited %d particles instead of %d\n", count,
+           scs->nPtcls());
+    ++fail;
+  }
+
+  //Move the remaining particles with a full rebuild
+  auto values = scs->get<0>();
+  scs->setShuffling(false);
+  moveParticles(scs, SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    values(particle_id) = (element_id + 1) % ne;
+    return (element_id + 1) % ne;
+  });
+  fail += checkActiveSlots(scs, count);
+  if (count != scs->nPtcls()) {
+    printf("[ERROR] The active loop visited %d particles instead of %d after rebuild\n",
+           count, scs->nPtcls());
+    ++fail;
+  }
+
+  //Without the list the active loop filters parallel_for
+  scs->setActiveSlots(false);
+  fail += checkActiveSlots(scs, count);
+  delete scs;
+  return fail == 0;
+}
+
+//Checks that the element arrays read by row hold the data of the element of the row
+int checkElementArrays(SCS* scs, int coords_id, int tag_id) {
+  auto coords = scs->getElementArray<double[3]>(coords_id);
+  auto tags = scs->getElementArray<int>(tag_id);
+  SCS::kkLidView fail("fail", 1);
+  auto checkRows = SCS_LAMBDA(const int& element_id, const int& row, const int& particle_id,
+                              const bool mask) {
+    if (!mask)
+      return;
+    if (tags(row) != 100 + element_id) {
+      printf("[ERROR] Row %d of element %d has tag %d\n", row, element_id, tags(row));
+      fail(0) = 1;
+    }
+    for (int i = 0; i < 3; ++i) {
+      if (coords(row, i) != element_id + i * 0.5) {
+        printf("[ERROR] Row %d of element %d has coordinate %f\n", row, element_id,
+               coords(row, i));
+        fail(0) = 1;
+      }
+    }
+  };
+  scs->parallel_for_rows(checkRows);
+  return getLastValue<lid_t>(fail);
+}
+
+bool elementArrayTest() {
+  printf("\n\nElement Array Test\n");
+  //Half of the elements start without particles and get no row
+  int ne = 20;
+  int np = 10;
+  particle_structs::CapacityPolicy cap_policy(1.1, 0, 0, 0, 0, false, true);
+  SCS* scs = makeSCS<SCS>(ne, np, 5, 2, cap_policy);
+  particle_structs::MemberTypeView<double[3]> coords("coords", ne);
+  particle_structs::MemberTypeView<int> tags("tags", ne);
+  Kokkos::parallel_for(ne, KOKKOS_LAMBDA(const int& i) {
+    tags(i) = 100 + i;
+    for (int j = 0; j < 3; ++j)
+      coords(i, j) = i + j * 0.5;
+  });
+  const int coords_id = scs->addElementArray(coords);
+  const int tag_id = scs->addElementArray(tags);
+  int fail = checkElementArrays(scs, coords_id, tag_id);
+
+  //Send every particle to an element without a row and back
+  scs->setShuffling(false);
+  for (int step = 0; step < 2; ++step) {
+    moveParticles(scs, SCS_LAMBDA(const int& element_id, const int& particle_id,
+                                  const bool mask) {
+      return (element_id + ne / 2) % ne;
+    });
+    fail += checkElementArrays(scs, coords_id, tag_id);
+  }
+  delete scs;
+  return fail == 0;
+}
+
+//Checks the particles per element of the structure against a count of the particles
+int checkOccupancy(SCS* scs) {
+  const int ne = scs->nElems();
+  SCS::kkLidView counts("counts", ne);
+  auto countParticles = SCS_LAMBDA(const int& element_id, const int& particle_id,
+                                   const bool mask) {
+    if (mask)
+      Kokkos::atomic_fetch_add(&counts(element_id), 1);
+  };
+  scs->parallel_for(countParticles);
+  auto occupancy = scs->particlesPerElement();
+  SCS::kkLidView fail("fail", 1);
+  Kokkos::parallel_for(ne, KOKKOS_LAMBDA(const int& i) {
+    if (occupancy(i) != counts(i)) {
+      printf("[ERROR] Element %d has %d particles but the structure counts %d\n", i,
+             counts(i), occupancy(i));
+      fail(0) = 1;
+    }
+  });
+  return getLastValue<lid_t>(fail);
+}
+
+bool occupancyTest() {
+  printf("\n\nOccupancy Test\n");
+  int ne = 10;
+  int np = 200;
+  SCS* scs = makeSCS<SCS>(ne, np, 5, 2);
+  int fail = checkOccupancy(scs);
+
+  //Remove every other particle, move every fourth one and inject particles with a reshuffle
+  SCS::kkLidView new_element = newElements(scs, SCS_LAMBDA(const int& element_id,
+                                                           const int& particle_id,
+                                                           const bool mask) {
+    if (particle_id % 2)
+      return -1;
+    return particle_id % 4 ? element_id : (element_id + 1) % ne;
+  });
+  const int nnew = 5;
+  SCS::kkLidView new_particle_elements("new_particle_elements", nnew);
+  particle_structs::MemberTypeViews<Type> new_particles =
+    particle_structs::createMemberViews<Type>(nnew);
+  Kokkos::parallel_for(nnew, KOKKOS_LAMBDA(const int& i) {
+    new_particle_elements(i) = 3;
+  });
+  if (!scs->reshuffle(new_element, new_particle_elements, new_particles)) {
+    printf("[ERROR] Reshuffle into the removed particles failed\n");
+    ++fail;
+  }
+  fail += checkOccupancy(scs);
+
+  //A rebuild whose reshuffle fails recounts the particles
+  moveParticles(scs, SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    return element_id < ne / 2 ? 0 : element_id;
+  });
+  fail += checkOccupancy(scs);
+
+  //Move the particles and inject more with a full rebuild
+  scs->setShuffling(false);
+  auto shiftParticles = SCS_LAMBDA(const int& element_id, const int& particle_id,
+                                   const bool mask) {
+    return (element_id + 2) % ne;
+  };
+  scs->rebuild(newElements(scs, shiftParticles), new_particle_elements, new_particles);
+  fail += checkOccupancy(scs);
+  particle_structs::destroyViews<Type>(new_particles);
+
+  //Removing every particle empties the counts
+  SCS::kkLidView removed("removed", scs->capacity());
+  Kokkos::deep_copy(removed, -1);
+  scs->rebuild(removed);
+  fail += checkOccupancy(scs);
+  delete scs;
+  return fail == 0;
+}
+
+//Checks every particle holds offset + its element and returns the number of particles
+int checkSnapshotValues(TiledSCS* scs, int offset, lid_t& count) {
+  auto values = scs->getConst<0>();
+  auto coords = scs->getConst<1>();
+  TiledSCS::kkLidView fail("fail", 1);
+  TiledSCS::kkLidView num("num", 1);
+  auto checkParticle = SCS_LAMBDA(const int& element_id, const int& particle_id,
+                                  const bool mask) {
+    if (mask) {
+      Kokkos::atomic_fetch_add(&num(0), 1);
+      if (values(particle_id) != offset + element_id ||
+          coords(particle_id, 2) != offset + element_id + 0.5) {
+        printf("[ERROR] Particle %d of element %d has value %d instead of %d\n", particle_id,
+               element_id, values(particle_id), offset + element_id);
+        fail(0) = 1;
+      }
+    }
+  };
+  scs->parallel_for(checkParticle);
+  count = getLastValue<lid_t>(num);
+  return getLastValue<lid_t>(fail);
+}
+
+//Moves every particle to the next element and sets its values for the new element
+void moveAndSet(TiledSCS* scs, int ne, int offset, bool remove) {
+  auto values = scs->get<0>();
+  auto coords = scs->get<1>();
+  moveParticles(scs, SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    const int elem = (element_id + 1) % ne;
+    values(particle_id) = offset + elem;
+    coords(particle_id, 2) = offset + elem + 0.5;
+    return remove && particle_id % 3 == 0 ? -1 : elem;
+  });
+}
+
+//Moves or removes the particles without writing to the members
+void shiftParticles(TiledSCS* scs, int ne, bool remove) {
+  moveParticles(scs, SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    if (remove)
+      return particle_id % 3 == 0 ? -1 : element_id;
+    return (element_id + 1) % ne;
+  });
+}
+
+bool snapshotTest() {
+  printf("\n\nSnapshot Test\n");
+  int ne = 10;
+  int np = 200;
+  particle_structs::CapacityPolicy cap_policy(1.1, 0, 0, 20);
+  TiledSCS* scs = makeSCS<TiledSCS>(ne, np, 5, 2, cap_policy);
+  auto coords = scs->get<1>();
+  auto setCoords = SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    coords(particle_id, 2) = element_id + 0.5;
+  };
+  scs->parallel_for(setCoords);
+  //Rebuild in place to reserve the row slack the reshuffle moves into
+  scs->setShuffling(false);
+  moveParticles(scs, SCS_LAMBDA(const int& element_id, const int& particle_id, const bool mask) {
+    return element_id;
+  });
+  TiledSCS* snap = scs->snapshot();
+  lid_t count;
+  int fail = 0;
+
+  //Roll back reshuffles and full rebuilds that do not write to the members first
+  for (int step = 0; step < 2; ++step) {
+    scs->setShuffling(step == 0);
+    shiftParticles(scs, ne, step == 0);
+    shiftParticles(scs, ne, false);
+    if (step == 0)
+      scs->setMemberTiling(true);
+    moveAndSet(scs, ne, 1000, true);
+    fail += checkSnapshotValues(scs, 1000, count);
+    if (count != scs->nPtcls() || count == np) {
+      printf("[ERROR] Step %d left %d particles\n", step, count);
+      ++fail;
+    }
+    //The snapshot is unchanged by the step
+    fail += checkSnapshotValues(snap, 0, count);
+    if (count != np) {
+      printf("[ERROR] Snapshot has %d particles instead of %d\n", count, np);
+      ++fail;
+    }
+    scs->restore(snap);
+    fail += checkSnapshotValues(scs, 0, count);
+    if (count != np || scs->nPtcls() != np) {
+      printf("[ERROR] Restored structure has %d particles instead of %d\n", count, np);
+      ++fail;
+    }
+  }
+
+  //Writes to the snapshot do not reach the restored structure
+  moveAndSet(snap, ne, 2000, false);
+  fail += checkSnapshotValues(scs, 0, count);
+  fail += checkSnapshotValues(snap, 2000, count);
+  delete snap;
+  delete scs;
+  return fail == 0;
+}
+
+/* Checks that the rows of each sigma window hold the elements of one 2x2x2 block of the
+   4x4x4 grid of cells when ordered (see mortonKeys), otherwise consecutive element ids
+*/
+int checkWindows(SCS* scs, int tag_id, SCS::kkLidView cells, int sigma, bool ordered) {
+  const int ne = scs->nElems();
+  auto tags = scs->getElementArray<int>(tag_id);
+  SCS::kkLidView fail("fail", 1);
+  Kokkos::parallel_for(ne / sigma, KOKKOS_LAMBDA(const int& w) {
+    int lo[3] = {4, 4, 4}, hi[3] = {0, 0, 0};
+    for (int r = w * sigma; r < (w + 1) * sigma; ++r) {
+      const int elem = tags(r);
+      if (!ordered && elem / sigma != w) {
+        printf("[ERROR] Row %d holds element %d outside of window %d\n", r, elem, w);
+        fail(0) = 1;
+      }
+      const int cell[3] = {cells(elem) % 4, cells(elem) / 4 % 4, cells(elem) / 16};
+      for (int d = 0; d < 3; ++d) {
+        lo[d] = cell[d] < lo[d] ? cell[d] : lo[d];
+        hi[d] = cell[d] > hi[d] ? cell[d] : hi[d];
+      }
+    }
+    for (int d = 0; ordered && d < 3; ++d) {
+      if (hi[d] - lo[d] > 1 || lo[d] % 2) {
+        printf("[ERROR] Window %d spans cells %d to %d in direction %d\n", w, lo[d], hi[d], d);
+        fail(0) = 1;
+      }
+    }
+  });
+  return getLastValue<lid_t>(fail);
+}
+
+bool elementOrderTest() {
+  printf("\n\nElement Order Test\n");
+  //The elements are the cells of a 4x4x4 grid numbered out of spatial order
+  const int ne = 64;
+  const int np = 640;
+  const int sigma = 8;
+  SCS* scs = makeSCS<SCS>(ne, np, sigma, 2);
+  SCS::kkLidView cells("cells", ne);
+  particle_structs::MemberTypeView<int> tags("tags", ne);
+  particle_structs::MemberTypeView<double[3]> centroids("centroids", ne);
+  Kokkos::parallel_for(ne, KOKKOS_LAMBDA(const int& i) {
+    cells(i) = i * 37 % ne;
+    tags(i) = i;
+    centroids(i, 0) = cells(i) % 4 + 0.5;
+    centroids(i, 1) = cells(i) / 4 % 4 + 0.5;
+    centroids(i, 2) = cells(i) / 16 + 0.5;
+  });
+  const int tag_id = scs->addElementArray(tags);
+  int fail = checkWindows(scs, tag_id, cells, sigma, false);
+  scs->setShuffling(false);
+
+  //Order the elements by their Morton index, move a few particles which changes the counts
+  //  but not the windows and restore the order of the element ids
+  for (int step = 0; step < 3; ++step) {
+    if (step == 0)
+      scs->setElementOrder(particle_structs::mortonKeys<exe_space>(centroids));
+    if (step == 2)
+      scs->setElementOrder(SCS::kkLidView());
+    const bool move = step == 1;
+    moveParticles(scs, SCS_LAMBDA(const int& element_id, const int& particle_id,
+                                  const bool mask) {
+      if (!mask)
+        return -1;
+      return move && element_id % 9 == 0 ? (element_id + 1) % ne : element_id;
+    });
+    fail += checkWindows(scs, tag_id, cells, sigma, step < 2);
+    fail += checkOccupancy(scs);
+  }
+  delete scs;
+  return fail == 0;
+}
+
+//Checks that the values of the particles of each element do not decrease with their slot
+int checkSortedElements(SCS* scs) {
+  const int cap = scs->capacity();
+  auto values = scs->get<0>();
+  SCS::kkLidView slot_elements("slot_elements", cap);
+  auto setElements = SCS_LAMBDA(const int& element_id, const int& particle_id,
+                                const bool mask) {
+    slot_elements(particle_id) = mask ? element_id : -1;
+  };
+  scs->parallel_for(setElements);
+  SCS::kkLidView slot_values("slot_values", cap);
+  Kokkos::parallel_for(cap, KOKKOS_LAMBDA(const int& i) {
+    slot_values(i) = slot_elements(i) != -1 ? values(i) : 0;
+  });
+  auto elements_host = particle_structs::deviceToHost(slot_elements);
+  auto values_host = particle_structs::deviceToHost(slot_values);
+  std::vector<int> last(scs->nElems(), -1);
+  int fail = 0;
+  for (int i = 0; i < cap; ++i) {
+    const int elem = elements_host(i);
+    if (elem == -1)
+      continue;
+    if (values_host(i) < last[elem]) {
+      printf("[ERROR] Particle %d of element %d has value %d after %d\n", i, elem,
+             values_host(i), last[elem]);
+      fail = 1;
+    }
+    last[elem] = values_host(i);
+  }
+  return fail;
+}
+
+bool sortedRebuildTest() {
+  printf("\n\nSorted Rebuild Test\n");
+  int ne = 10;
+  int np = 200;
+  //Heavy elements spill into the overflow region which follows the rows of the element
+  particle_structs::CapacityPolicy cap_policy(1.1, 0, 0, 0, 12);
+  SCS* scs = makeSCS<SCS>(ne, np, 5, 2, cap_policy);
+  int fail = 0;
+  for (int step = 0; step < 2; ++step) {
+    //Shift the particles to the next element and give them scrambled values as keys
+    auto values = scs->get<0>();
+    SCS::kkLidView new_element = newElements(scs, SCS_LAMBDA(const int& element_id,
+                                                             const int& particle_id,
+                                                             const bool mask) {
+      values(particle_id) = particle_id * 7919 % 97;
+      return mask ? (element_id + step + 1) % ne : -1;
+    });
+    auto key = SCS_LAMBDA(const lid_t& particle_id) {
+      return values(particle_id);
+    };
+    //New particles follow the sorted particles of their element
+    SCS::kkLidView new_particle_elements("new_particle_elements", ne);
+    particle_structs::MemberTypeViews<Type> new_particles =
+      particle_structs::createMemberViews<Type>(ne);
+    auto new_values = particle_structs::getMemberView<Type, 0>(new_particles);
+    Kokkos::parallel_for(ne, KOKKOS_LAMBDA(const int& i) {
+      new_particle_elements(i) = i;
+      new_values(i) = 1000;
+    });
+    scs->rebuild(new_element, key, new_particle_elements, new_particles);
+    particle_structs::destroyViews<Type>(new_particles);
+    fail += checkSortedElements(scs);
+    fail += checkOccupancy(scs);
+    if (scs->nPtcls() != np + (step + 1) * ne) {
+      printf("[ERROR] Sorted rebuild has %d particles instead of %d\n", scs->nPtcls(),
+             np + (step + 1) * ne);
+      ++fail;
+    }
+  }
+  delete scs;
+  return fail == 0;
+}
@@ -6,6 +6,7 @@
 #include <SellCSigma.h>
 #include <Distribute.h>
 #include <psAssert.h>
+#include <psTypes.h>
 
 using particle_structs::SellCSigma;
 using particle_structs::MemberTypes;
@@ -28,6 +29,16 @@ int main(int argc, char** argv) {
   printf("Type3 start of doubles: %lu\n",Type3::sizeToIndex<1>());
   PS_ALWAYS_ASSERT(Type3::sizeToIndex<1>() == 3*sizeof(int));
 
+  //Single and double precision species in the same build
+  typedef particle_structs::ParticleOf<float> ParticleFP32;
+  typedef particle_structs::ParticleOf<double> ParticleFP64;
+  printf("ParticleFP32: %lu ParticleFP64: %lu\n", ParticleFP32::memsize, ParticleFP64::memsize);
+  PS_ALWAYS_ASSERT(ParticleFP32::memsize == 6*sizeof(float));
+  PS_ALWAYS_ASSERT(ParticleFP64::memsize == 6*sizeof(double));
+  particle_structs::elemCoordsOf<float> coords32(5, 4, 2);
+  particle_structs::elemCoords coords(5, 4, 2);
+  PS_ALWAYS_ASSERT(coords32.size == coords.size);
+
   int ne = 5;
   int np = 10;
   int* ptcls_per_elem = new int[ne];
@@ -63,6 +74,25 @@ int main(int argc, char** argv) {
       }
     };
     scs->parallel_for(setValues);
+
+    //Write through an unmanaged restrict segment and read back through read only ones
+    typedef Kokkos::MemoryTraits<Kokkos::Unmanaged | Kokkos::Restrict> PushTraits;
+    auto scs_first_restrict = scs->get<0, PushTraits>();
+    auto setRestrict = SCS_LAMBDA(int element_id, int particle_id, bool mask) {
+      if (mask)
+        scs_first_restrict(particle_id) = element_id + 1;
+    };
+    scs->parallel_for(setRestrict);
+    auto scs_first_const = scs->getConst<0, Kokkos::MemoryRandomAccess>();
+    auto scs_second_const = scs->getConst<1>();
+    SCS::kkLidView fail("fail", 1);
+    auto checkValues = SCS_LAMBDA(int element_id, int particle_id, bool mask) {
+      if (mask && (scs_first_const(particle_id) != element_id + 1 ||
+                   scs_second_const(particle_id, 0) != 2.0))
+        fail(0) = 1;
+    };
+    scs->parallel_for(checkValues);
+    PS_ALWAYS_ASSERT(particle_structs::getLastValue<int>(fail) == 0);
     delete scs;
   }
 